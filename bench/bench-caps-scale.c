@@ -0,0 +1,278 @@
+/*
+ * bench-caps-scale.c: guest lookup latency versus capabilities size
+ *
+ * Copyright (C) 2026 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#include <config.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench-common.h"
+
+#define BENCH_SUITE "caps-scale"
+
+/* The arch every lookup is done for, it is always emitted last */
+#define BENCH_TARGET_ARCH "x86_64"
+
+static const char * const bench_arches[] = {
+    "i686", "aarch64", "armv7l", "ppc64", "ppc64le", "s390x",
+    "mips", "mipsel", "mips64", "riscv64", "sparc64", "alpha",
+};
+
+/* KVM comes last so that picking the best domain scans them all */
+static const char * const bench_virt_types[] = {
+    "qemu", "kqemu", "xen", "test", "vmware", "kvm",
+};
+
+typedef struct {
+    guint n_arches;     /* guest arches besides the target one */
+    guint n_domains;    /* <domain> elements per arch, at most 6 */
+    guint n_machines;   /* <machine> elements per domain */
+} BenchCapsParams;
+
+enum {
+    OP_PARSE,
+    OP_SUPPORTS_MACHINE,
+    OP_SUPPORTS_CONTAINER_FULL,
+    OP_SETUP_MACHINE_FULL,
+    OP_LAST
+};
+
+static const char *op_names[OP_LAST] = {
+    "parse",
+    "supports_machine",
+    "supports_container_full",
+    "setup_machine_full",
+};
+
+
+static void
+bench_caps_append_guest(GString *xml,
+                        const char *os_type,
+                        const char *arch,
+                        const BenchCapsParams *params)
+{
+    guint i, j;
+
+    g_string_append_printf(xml,
+                           "  <guest>\n"
+                           "    <os_type>%s</os_type>\n"
+                           "    <arch name='%s'>\n"
+                           "      <wordsize>64</wordsize>\n"
+                           "      <emulator>/usr/bin/qemu-system-%s</emulator>\n",
+                           os_type, arch, arch);
+    for (j = 0; j < params->n_machines; j++)
+        g_string_append_printf(xml, "      <machine>bench-%u.0</machine>\n", j);
+
+    for (i = 0; i < params->n_domains; i++) {
+        /* always finish with kvm */
+        guint type = G_N_ELEMENTS(bench_virt_types) - params->n_domains + i;
+
+        g_string_append_printf(xml, "      <domain type='%s'>\n",
+                               bench_virt_types[type]);
+        for (j = 0; j < params->n_machines; j++)
+            g_string_append_printf(xml, "        <machine>bench-%u.0</machine>\n", j);
+        g_string_append(xml, "      </domain>\n");
+    }
+
+    g_string_append(xml,
+                    "    </arch>\n"
+                    "    <features>\n"
+                    "      <acpi default='on' toggle='yes'/>\n"
+                    "      <apic default='on' toggle='no'/>\n"
+                    "    </features>\n"
+                    "  </guest>\n");
+}
+
+
+/* Every arch has a 'hvm', a 'xen' and an 'exe' guest, the target arch
+ * comes last so all the lookups have to go through the whole list */
+static gchar *
+bench_caps_xml_new(const BenchCapsParams *params)
+{
+    static const char * const os_types[] = { "xen", "exe", "hvm" };
+    GString *xml = g_string_new(NULL);
+    guint i, j;
+
+    g_string_append(xml,
+                    "<capabilities>\n"
+                    "  <host>\n"
+                    "    <uuid>b9d70ef8-6756-4b51-8901-f0e65af0dcd8</uuid>\n"
+                    "    <cpu>\n"
+                    "      <arch>" BENCH_TARGET_ARCH "</arch>\n"
+                    "      <model>Haswell</model>\n"
+                    "      <vendor>Intel</vendor>\n"
+                    "      <topology sockets='2' cores='8' threads='2'/>\n"
+                    "    </cpu>\n"
+                    "  </host>\n");
+
+    for (i = 0; i < params->n_arches; i++) {
+        gchar *arch;
+
+        if (i < G_N_ELEMENTS(bench_arches))
+            arch = g_strdup(bench_arches[i]);
+        else
+            arch = g_strdup_printf("bench%u", i);
+
+        for (j = 0; j < G_N_ELEMENTS(os_types); j++)
+            bench_caps_append_guest(xml, os_types[j], arch, params);
+        g_free(arch);
+    }
+
+    for (j = 0; j < G_N_ELEMENTS(os_types); j++)
+        bench_caps_append_guest(xml, os_types[j], BENCH_TARGET_ARCH, params);
+
+    g_string_append(xml, "</capabilities>\n");
+
+    return g_string_free(xml, FALSE);
+}
+
+
+static void
+bench_caps_run(const char *variant,
+               const BenchCapsParams *params,
+               guint iterations)
+{
+    OsinfoDb *db = osinfo_db_new();
+    OsinfoOs *os = osinfo_os_new("http://bench.libvirt.org/os/0");
+    OsinfoPlatform *platform = osinfo_platform_new("http://bench.libvirt.org/platform/0");
+    BenchStat stats[OP_LAST];
+    gchar *xml = bench_caps_xml_new(params);
+    guint i;
+
+    memset(stats, 0, sizeof(stats));
+    for (i = 0; i < OP_LAST; i++)
+        stats[i].op = op_names[i];
+
+    for (i = 0; i < iterations; i++) {
+        GVirConfigCapabilities *caps;
+        GVirDesignerDomain *design;
+        GError *error = NULL;
+        BenchStart start;
+
+        bench_start(&start);
+        caps = gvir_config_capabilities_new_from_xml(xml, &error);
+        bench_stat_add(&stats[OP_PARSE], &start);
+        if (caps == NULL)
+            g_error("Unable to parse capabilities: %s", error->message);
+
+        design = gvir_designer_domain_new(db, os, platform, caps);
+
+        bench_start(&start);
+        if (!gvir_designer_domain_supports_machine(design))
+            g_error("%s: no machine for the host arch", variant);
+        bench_stat_add(&stats[OP_SUPPORTS_MACHINE], &start);
+
+        bench_start(&start);
+        if (!gvir_designer_domain_supports_container_full(design,
+                                                          BENCH_TARGET_ARCH))
+            g_error("%s: no container for " BENCH_TARGET_ARCH, variant);
+        bench_stat_add(&stats[OP_SUPPORTS_CONTAINER_FULL], &start);
+
+        /* the cost of picking the best guest domain is part of this one,
+         * it is what grows with the number of <domain> elements */
+        bench_start(&start);
+        gvir_designer_domain_setup_machine_full(design, BENCH_TARGET_ARCH,
+                                                GVIR_CONFIG_DOMAIN_OS_TYPE_HVM,
+                                                &error);
+        bench_stat_add(&stats[OP_SETUP_MACHINE_FULL], &start);
+        if (error)
+            g_error("%s: %s", variant, error->message);
+
+        g_object_unref(design);
+        g_object_unref(caps);
+    }
+
+    for (i = 0; i < OP_LAST; i++)
+        bench_report(BENCH_SUITE, variant, &stats[i]);
+
+    g_free(xml);
+    g_object_unref(platform);
+    g_object_unref(os);
+    g_object_unref(db);
+}
+
+
+int
+main(int argc, char **argv)
+{
+    static gint iterations = 100;
+    static gint max_arches = 64;
+    static gint max_machines = 64;
+    GOptionEntry entries[] = {
+        { "iterations", 'i', 0, G_OPTION_ARG_INT, &iterations,
+          "number of lookups per capabilities document", "N" },
+        { "max-arches", 0, 0, G_OPTION_ARG_INT, &max_arches,
+          "largest number of guest arches, doubling from 1", "N" },
+        { "max-machines", 0, 0, G_OPTION_ARG_INT, &max_machines,
+          "largest number of machine types per domain, doubling from 1", "N" },
+        { NULL }
+    };
+    GOptionContext *context;
+    GError *error = NULL;
+    guint n;
+
+    if (!gvir_designer_init_check(&argc, &argv, NULL))
+        return EXIT_FAILURE;
+
+    context = g_option_context_new("- measure guest lookups versus capabilities size");
+    g_option_context_add_main_entries(context, entries, NULL);
+    if (!g_option_context_parse(context, &argc, &argv, &error)) {
+        g_printerr("option parsing failed: %s\n", error->message);
+        g_option_context_free(context);
+        return EXIT_FAILURE;
+    }
+    g_option_context_free(context);
+
+    if (iterations <= 0 || max_arches <= 0 || max_machines <= 0) {
+        g_printerr("all options must be positive\n");
+        return EXIT_FAILURE;
+    }
+
+    bench_report_header();
+
+    /* more guest/arch combinations */
+    for (n = 1; n <= (guint)max_arches; n *= 2) {
+        BenchCapsParams params = { n, 2, 4 };
+        gchar *variant = g_strdup_printf("arches-%u", n);
+
+        bench_caps_run(variant, &params, iterations);
+        g_free(variant);
+    }
+
+    /* more domain types per arch */
+    for (n = 1; n <= G_N_ELEMENTS(bench_virt_types); n++) {
+        BenchCapsParams params = { 8, n, 4 };
+        gchar *variant = g_strdup_printf("domains-%u", n);
+
+        bench_caps_run(variant, &params, iterations);
+        g_free(variant);
+    }
+
+    /* more machine types per domain */
+    for (n = 1; n <= (guint)max_machines; n *= 2) {
+        BenchCapsParams params = { 8, 2, n };
+        gchar *variant = g_strdup_printf("machines-%u", n);
+
+        bench_caps_run(variant, &params, iterations);
+        g_free(variant);
+    }
+
+    return EXIT_SUCCESS;
+}
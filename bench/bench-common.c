@@ -0,0 +1,212 @@
+/*
+ * bench-common.c: helpers shared by the libvirt-designer benchmarks
+ *
+ * Copyright (C) 2026 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#include <config.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "bench-common.h"
+
+static const gchar *bench_capsxml =
+    "<capabilities>"
+    "  <host>"
+    "    <uuid>b9d70ef8-6756-4b51-8901-f0e65af0dcd8</uuid>"
+    "    <cpu>"
+    "      <arch>x86_64</arch>"
+    "      <model>core2duo</model>"
+    "      <vendor>Intel</vendor>"
+    "      <topology sockets='1' cores='2' threads='1'/>"
+    "    </cpu>"
+    "  </host>"
+    "  <guest>"
+    "    <os_type>hvm</os_type>"
+    "    <arch name='x86_64'>"
+    "      <wordsize>64</wordsize>"
+    "      <emulator>/usr/bin/qemu-system-x86_64</emulator>"
+    "      <machine>pc-1.0</machine>"
+    "      <machine canonical='pc-1.0'>pc</machine>"
+    "      <domain type='qemu'>"
+    "      </domain>"
+    "      <domain type='kvm'>"
+    "        <emulator>/usr/bin/qemu-kvm</emulator>"
+    "        <machine>pc-1.0</machine>"
+    "        <machine canonical='pc-1.0'>pc</machine>"
+    "      </domain>"
+    "    </arch>"
+    "  </guest>"
+    "</capabilities>";
+
+
+/* With glibc, malloc() and friends are interposed so that every heap
+ * allocation made by the process, including the ones from GLib and
+ * libxml2, is counted. Other C libraries report no allocation counts.
+ */
+#ifdef __GLIBC__
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t nmemb, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+
+static guint64 bench_n_allocs;
+
+void *
+malloc(size_t size)
+{
+    __atomic_add_fetch(&bench_n_allocs, 1, __ATOMIC_RELAXED);
+    return __libc_malloc(size);
+}
+
+
+void *
+calloc(size_t nmemb, size_t size)
+{
+    __atomic_add_fetch(&bench_n_allocs, 1, __ATOMIC_RELAXED);
+    return __libc_calloc(nmemb, size);
+}
+
+
+void *
+realloc(void *ptr, size_t size)
+{
+    if (ptr == NULL)
+        __atomic_add_fetch(&bench_n_allocs, 1, __ATOMIC_RELAXED);
+    return __libc_realloc(ptr, size);
+}
+
+
+gboolean
+bench_allocs_counted(void)
+{
+    return TRUE;
+}
+
+
+guint64
+bench_allocs(void)
+{
+    return __atomic_load_n(&bench_n_allocs, __ATOMIC_RELAXED);
+}
+#else /* !__GLIBC__ */
+gboolean
+bench_allocs_counted(void)
+{
+    return FALSE;
+}
+
+
+guint64
+bench_allocs(void)
+{
+    return 0;
+}
+#endif /* !__GLIBC__ */
+
+
+guint64
+bench_clock_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (guint64)ts.tv_sec * G_GUINT64_CONSTANT(1000000000) + ts.tv_nsec;
+}
+
+
+void
+bench_start(BenchStart *start)
+{
+    start->allocs = bench_allocs();
+    start->ns = bench_clock_ns();
+}
+
+
+void
+bench_stat_add(BenchStat *stat,
+               const BenchStart *start)
+{
+    stat->total_ns += bench_clock_ns() - start->ns;
+    stat->allocs += bench_allocs() - start->allocs;
+    stat->count++;
+}
+
+
+/* All the benchmarks print one tab separated line per operation so that
+ * their output can be concatenated and compared. The key is made of the
+ * benchmark name, the variant (usually the input size) and the operation.
+ * Allocations are reported as '-' when they cannot be counted.
+ */
+void
+bench_report_header(void)
+{
+    printf("# key\tns/op\tcount\tallocs/op\n");
+}
+
+
+void
+bench_report(const char *suite,
+             const char *variant,
+             const BenchStat *stat)
+{
+    if (stat->count == 0)
+        return;
+
+    printf("%s/%s/%s\t%" G_GUINT64_FORMAT "\t%" G_GUINT64_FORMAT,
+           suite, variant, stat->op,
+           stat->total_ns / stat->count, stat->count);
+    if (bench_allocs_counted())
+        printf("\t%" G_GUINT64_FORMAT "\n", stat->allocs / stat->count);
+    else
+        printf("\t-\n");
+    fflush(stdout);
+}
+
+
+/* Resident set size of the process, 0 if it cannot be read */
+guint64
+bench_rss_bytes(void)
+{
+    unsigned long size, resident;
+    FILE *fp;
+
+    if (!(fp = fopen("/proc/self/statm", "r")))
+        return 0;
+    if (fscanf(fp, "%lu %lu", &size, &resident) != 2)
+        resident = 0;
+    fclose(fp);
+
+    return (guint64)resident * sysconf(_SC_PAGESIZE);
+}
+
+
+GVirConfigCapabilities *
+bench_capabilities_new(void)
+{
+    GError *error = NULL;
+    GVirConfigCapabilities *caps;
+
+    caps = gvir_config_capabilities_new_from_xml(bench_capsxml, &error);
+    if (caps == NULL)
+        g_error("Unable to parse capabilities: %s", error->message);
+
+    return caps;
+}
@@ -0,0 +1,68 @@
+/*
+ * bench-common.h: helpers shared by the libvirt-designer benchmarks
+ *
+ * Copyright (C) 2026 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __BENCH_COMMON_H__
+#define __BENCH_COMMON_H__
+
+#include <libvirt-designer/libvirt-designer.h>
+
+G_BEGIN_DECLS
+
+typedef struct _BenchStat BenchStat;
+typedef struct _BenchStart BenchStart;
+
+struct _BenchStat
+{
+    const char *op;
+    guint64 total_ns;
+    guint64 count;
+    guint64 allocs;
+};
+
+/* Where an operation started, see bench_start() */
+struct _BenchStart
+{
+    guint64 ns;
+    guint64 allocs;
+};
+
+guint64 bench_clock_ns(void);
+
+gboolean bench_allocs_counted(void);
+guint64 bench_allocs(void);
+
+void bench_start(BenchStart *start);
+
+void bench_stat_add(BenchStat *stat,
+                    const BenchStart *start);
+
+void bench_report_header(void);
+
+void bench_report(const char *suite,
+                  const char *variant,
+                  const BenchStat *stat);
+
+guint64 bench_rss_bytes(void);
+
+GVirConfigCapabilities *bench_capabilities_new(void);
+
+G_END_DECLS
+
+#endif /* __BENCH_COMMON_H__ */
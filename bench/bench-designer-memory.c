@@ -0,0 +1,355 @@
+/*
+ * bench-designer-memory.c: memory footprint of live designers
+ *
+ * Copyright (C) 2026 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#include <config.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+#include "bench-common.h"
+#include "bench-osinfo-gen.h"
+
+#define BENCH_SUITE "designer-memory"
+
+#define CHECK_ERROR \
+    if (error) {                                        \
+        g_error("%s: %s", G_STRLOC, error->message);    \
+    }
+
+
+/* GObject only counts instances when asked to at startup, so re-run
+ * ourselves with the debug flag set if it is missing. Instance counts
+ * need GLib 2.44, they are all 0 before. */
+static void
+bench_enable_instance_count(char **argv)
+{
+    const char *debug = g_getenv("GOBJECT_DEBUG");
+    gchar *value;
+
+    if (!GLIB_CHECK_VERSION(2, 44, 0) ||
+        (debug && strstr(debug, "instance-count")))
+        return;
+
+    if (debug)
+        value = g_strdup_printf("%s,instance-count", debug);
+    else
+        value = g_strdup("instance-count");
+    g_setenv("GOBJECT_DEBUG", value, TRUE);
+    g_free(value);
+
+    execv("/proc/self/exe", argv);
+    g_printerr("unable to re-execute with GOBJECT_DEBUG=instance-count, "
+               "object counts will be missing\n");
+}
+
+
+static void
+bench_instance_counts_fill(GHashTable *counts, GType type)
+{
+    GType *children;
+    guint n_children, i;
+
+#if GLIB_CHECK_VERSION(2, 44, 0)
+    g_hash_table_insert(counts, GSIZE_TO_POINTER(type),
+                        GINT_TO_POINTER(g_type_get_instance_count(type)));
+#endif
+
+    children = g_type_children(type, &n_children);
+    for (i = 0; i < n_children; i++)
+        bench_instance_counts_fill(counts, children[i]);
+    g_free(children);
+}
+
+
+/* Live instances of every GObject type currently registered */
+static GHashTable *
+bench_instance_counts_new(void)
+{
+    GHashTable *counts = g_hash_table_new(NULL, NULL);
+
+    bench_instance_counts_fill(counts, G_TYPE_OBJECT);
+
+    return counts;
+}
+
+
+static gint
+bench_instance_counts_delta(GHashTable *before, GHashTable *after, GType type)
+{
+    return GPOINTER_TO_INT(g_hash_table_lookup(after, GSIZE_TO_POINTER(type))) -
+        GPOINTER_TO_INT(g_hash_table_lookup(before, GSIZE_TO_POINTER(type)));
+}
+
+
+static gint
+bench_type_compare(gconstpointer a, gconstpointer b)
+{
+    return g_strcmp0(g_type_name(GPOINTER_TO_SIZE(*(gconstpointer *)a)),
+                     g_type_name(GPOINTER_TO_SIZE(*(gconstpointer *)b)));
+}
+
+
+/* Types whose instance count differs, sorted by name */
+static GPtrArray *
+bench_instance_counts_changed(GHashTable *before, GHashTable *after)
+{
+    GPtrArray *types = g_ptr_array_new();
+    GHashTableIter iter;
+    gpointer key;
+
+    g_hash_table_iter_init(&iter, after);
+    while (g_hash_table_iter_next(&iter, &key, NULL)) {
+        if (bench_instance_counts_delta(before, after, GPOINTER_TO_SIZE(key)) != 0)
+            g_ptr_array_add(types, key);
+    }
+    g_ptr_array_sort(types, bench_type_compare);
+
+    return types;
+}
+
+
+static void
+bench_report_value(const char *variant,
+                   const char *name,
+                   gdouble per_design,
+                   guint n_designs)
+{
+    printf("%s/%s/%s\t%.1f\t%u\n",
+           BENCH_SUITE, variant, name, per_design, n_designs);
+    fflush(stdout);
+}
+
+
+/* Number of elements in a serialized document */
+static guint
+bench_xml_count_elements(const gchar *xml)
+{
+    guint n = 0;
+
+    for (; *xml; xml++) {
+        if (xml[0] == '<' && xml[1] != '/' && xml[1] != '?' && xml[1] != '!')
+            n++;
+    }
+
+    return n;
+}
+
+
+static GVirDesignerDomain *
+bench_design_new(BenchOsinfoDb *bdb,
+                 GVirConfigCapabilities *caps,
+                 guint n_disks)
+{
+    GVirDesignerDomain *design;
+    GError *error = NULL;
+    guint i;
+
+    design = gvir_designer_domain_new(bdb->db, bdb->os, bdb->platform, caps);
+
+    for (i = 0; i < bdb->driver_ids->len; i++) {
+        gvir_designer_domain_add_driver(design,
+                                        g_ptr_array_index(bdb->driver_ids, i),
+                                        &error);
+        CHECK_ERROR;
+    }
+
+    gvir_designer_domain_setup_machine(design, &error);
+    CHECK_ERROR;
+    gvir_designer_domain_setup_resources(design,
+                                         GVIR_DESIGNER_DOMAIN_RESOURCES_RECOMMENDED,
+                                         NULL);
+
+    for (i = 0; i < n_disks; i++) {
+        gchar *path = g_strdup_printf("/var/lib/libvirt/images/bench-%u.qcow2", i);
+
+        g_object_unref(gvir_designer_domain_add_disk_file(design, path,
+                                                          "qcow2", &error));
+        g_free(path);
+        CHECK_ERROR;
+    }
+
+    g_object_unref(gvir_designer_domain_add_interface_network(design, "default",
+                                                              &error));
+    CHECK_ERROR;
+    g_object_unref(gvir_designer_domain_add_video(design, &error));
+    CHECK_ERROR;
+    g_object_unref(gvir_designer_domain_add_sound(design, &error));
+    CHECK_ERROR;
+    g_object_unref(gvir_designer_domain_add_graphics(design,
+                                                     GVIR_DESIGNER_DOMAIN_GRAPHICS_SPICE,
+                                                     &error));
+    CHECK_ERROR;
+
+    return design;
+}
+
+
+/* Returns the number of objects still alive once all designers are gone */
+static gint
+bench_memory_run(BenchOsinfoDb *bdb,
+                 GVirConfigCapabilities *caps,
+                 guint n_designs,
+                 guint n_disks)
+{
+    GPtrArray *designs = g_ptr_array_new_with_free_func(g_object_unref);
+    GHashTable *counts_before, *counts_live, *counts_after;
+    GPtrArray *types;
+    guint64 rss_before, rss_live, xml_bytes = 0, xml_elements = 0;
+    gchar *variant = g_strdup_printf("disks-%u", n_disks);
+    gint leaked = 0;
+    guint i;
+
+#ifdef __GLIBC__
+    malloc_trim(0);
+#endif
+    counts_before = bench_instance_counts_new();
+    rss_before = bench_rss_bytes();
+
+    for (i = 0; i < n_designs; i++)
+        g_ptr_array_add(designs, bench_design_new(bdb, caps, n_disks));
+
+    rss_live = bench_rss_bytes();
+    counts_live = bench_instance_counts_new();
+
+    for (i = 0; i < n_designs; i++) {
+        GVirDesignerDomain *design = g_ptr_array_index(designs, i);
+        gchar *xml;
+
+        xml = gvir_config_object_to_xml(GVIR_CONFIG_OBJECT(gvir_designer_domain_get_config(design)));
+        xml_bytes += strlen(xml);
+        xml_elements += bench_xml_count_elements(xml);
+        g_free(xml);
+    }
+
+    bench_report_value(variant, "rss_bytes",
+                       rss_live > rss_before ?
+                       (gdouble)(rss_live - rss_before) / n_designs : 0,
+                       n_designs);
+    bench_report_value(variant, "xml_bytes",
+                       (gdouble)xml_bytes / n_designs, n_designs);
+    bench_report_value(variant, "xml_elements",
+                       (gdouble)xml_elements / n_designs, n_designs);
+
+    types = bench_instance_counts_changed(counts_before, counts_live);
+    for (i = 0; i < types->len; i++) {
+        GType type = GPOINTER_TO_SIZE(g_ptr_array_index(types, i));
+        gchar *name = g_strdup_printf("objects/%s", g_type_name(type));
+
+        bench_report_value(variant, name,
+                           (gdouble)bench_instance_counts_delta(counts_before,
+                                                                counts_live,
+                                                                type) / n_designs,
+                           n_designs);
+        g_free(name);
+    }
+    g_ptr_array_unref(types);
+
+    /* Everything a designer holds must go away with it */
+    g_ptr_array_unref(designs);
+    counts_after = bench_instance_counts_new();
+    types = bench_instance_counts_changed(counts_before, counts_after);
+    for (i = 0; i < types->len; i++) {
+        GType type = GPOINTER_TO_SIZE(g_ptr_array_index(types, i));
+        gint delta = bench_instance_counts_delta(counts_before, counts_after, type);
+
+        if (delta <= 0)
+            continue;
+        g_printerr("%s/%s: %d %s instances leaked\n",
+                   BENCH_SUITE, variant, delta, g_type_name(type));
+        leaked += delta;
+    }
+    g_ptr_array_unref(types);
+
+    g_hash_table_unref(counts_after);
+    g_hash_table_unref(counts_live);
+    g_hash_table_unref(counts_before);
+    g_free(variant);
+
+    return leaked;
+}
+
+
+int
+main(int argc, char **argv)
+{
+    static gint n_designs = 1000;
+    static gint max_disks = 16;
+    static BenchOsinfoDbParams params = {
+        .n_oses = 20,
+        .derives_depth = 4,
+        .n_platforms = 4,
+        .n_devices_per_class = 8,
+        .n_drivers = 2,
+        .n_deployments = 8,
+    };
+    GOptionEntry entries[] = {
+        { "designs", 'n', 0, G_OPTION_ARG_INT, &n_designs,
+          "number of designers kept alive at the same time", "N" },
+        { "max-disks", 'd', 0, G_OPTION_ARG_INT, &max_disks,
+          "largest number of disks per design, doubling from 1", "N" },
+        { NULL }
+    };
+    GOptionContext *context;
+    GError *error = NULL;
+    GVirConfigCapabilities *caps;
+    BenchOsinfoDb *bdb;
+    gint leaked = 0;
+    guint n_disks;
+
+    bench_enable_instance_count(argv);
+
+    if (!gvir_designer_init_check(&argc, &argv, NULL))
+        return EXIT_FAILURE;
+
+    context = g_option_context_new("- measure the memory used by live designers");
+    g_option_context_add_main_entries(context, entries, NULL);
+    if (!g_option_context_parse(context, &argc, &argv, &error)) {
+        g_printerr("option parsing failed: %s\n", error->message);
+        g_option_context_free(context);
+        return EXIT_FAILURE;
+    }
+    g_option_context_free(context);
+
+    if (n_designs <= 0) {
+        g_printerr("--designs must be positive\n");
+        return EXIT_FAILURE;
+    }
+    if (max_disks <= 0) {
+        g_printerr("--max-disks must be positive\n");
+        return EXIT_FAILURE;
+    }
+
+    caps = bench_capabilities_new();
+    bdb = bench_osinfo_db_new(&params);
+
+    printf("# key\tper-design\tdesigns\n");
+    for (n_disks = 1; n_disks <= (guint)max_disks; n_disks *= 2)
+        leaked += bench_memory_run(bdb, caps, n_designs, n_disks);
+
+    bench_osinfo_db_free(bdb);
+    g_object_unref(caps);
+
+    return leaked ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,255 @@
+/*
+ * bench-designer-scale.c: design latency versus libosinfo database size
+ *
+ * Copyright (C) 2026 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#include <config.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench-common.h"
+#include "bench-osinfo-gen.h"
+
+#define BENCH_SUITE "designer-scale"
+
+#define CHECK_ERROR \
+    if (error) {                                        \
+        g_error("%s: %s", G_STRLOC, error->message);    \
+    }
+
+enum {
+    OP_NEW,
+    OP_ADD_DRIVER,
+    OP_SETUP_MACHINE,
+    OP_SETUP_RESOURCES,
+    OP_ADD_DISK_FILE,
+    OP_ADD_INTERFACE_NETWORK,
+    OP_ADD_VIDEO,
+    OP_ADD_SOUND,
+    OP_ADD_GRAPHICS,
+    OP_TO_XML,
+    OP_FINALIZE,
+    OP_DESIGN,
+    OP_LAST
+};
+
+static const char *op_names[OP_LAST] = {
+    "new",
+    "add_driver",
+    "setup_machine",
+    "setup_resources",
+    "add_disk_file",
+    "add_interface_network",
+    "add_video",
+    "add_sound",
+    "add_graphics",
+    "to_xml",
+    "finalize",
+    "design",
+};
+
+
+static void
+bench_design_once(BenchOsinfoDb *bdb,
+                  GVirConfigCapabilities *caps,
+                  guint n_disks,
+                  BenchStat *stats)
+{
+    GVirDesignerDomain *design;
+    GError *error = NULL;
+    BenchStart design_start;
+    BenchStart start;
+    gchar *xml;
+    guint i;
+
+    bench_start(&design_start);
+    bench_start(&start);
+    design = gvir_designer_domain_new(bdb->db, bdb->os, bdb->platform, caps);
+    bench_stat_add(&stats[OP_NEW], &start);
+
+    for (i = 0; i < bdb->driver_ids->len; i++) {
+        bench_start(&start);
+        gvir_designer_domain_add_driver(design,
+                                        g_ptr_array_index(bdb->driver_ids, i),
+                                        &error);
+        bench_stat_add(&stats[OP_ADD_DRIVER], &start);
+        CHECK_ERROR;
+    }
+
+    bench_start(&start);
+    gvir_designer_domain_setup_machine(design, &error);
+    bench_stat_add(&stats[OP_SETUP_MACHINE], &start);
+    CHECK_ERROR;
+
+    bench_start(&start);
+    gvir_designer_domain_setup_resources(design,
+                                         GVIR_DESIGNER_DOMAIN_RESOURCES_RECOMMENDED,
+                                         NULL);
+    bench_stat_add(&stats[OP_SETUP_RESOURCES], &start);
+
+    for (i = 0; i < n_disks; i++) {
+        gchar *path = g_strdup_printf("/var/lib/libvirt/images/bench-%u.qcow2", i);
+
+        bench_start(&start);
+        g_object_unref(gvir_designer_domain_add_disk_file(design, path,
+                                                          "qcow2", &error));
+        bench_stat_add(&stats[OP_ADD_DISK_FILE], &start);
+        g_free(path);
+        CHECK_ERROR;
+    }
+
+    bench_start(&start);
+    g_object_unref(gvir_designer_domain_add_interface_network(design, "default",
+                                                              &error));
+    bench_stat_add(&stats[OP_ADD_INTERFACE_NETWORK], &start);
+    CHECK_ERROR;
+
+    bench_start(&start);
+    g_object_unref(gvir_designer_domain_add_video(design, &error));
+    bench_stat_add(&stats[OP_ADD_VIDEO], &start);
+    CHECK_ERROR;
+
+    bench_start(&start);
+    g_object_unref(gvir_designer_domain_add_sound(design, &error));
+    bench_stat_add(&stats[OP_ADD_SOUND], &start);
+    CHECK_ERROR;
+
+    bench_start(&start);
+    g_object_unref(gvir_designer_domain_add_graphics(design,
+                                                     GVIR_DESIGNER_DOMAIN_GRAPHICS_SPICE,
+                                                     &error));
+    bench_stat_add(&stats[OP_ADD_GRAPHICS], &start);
+    CHECK_ERROR;
+
+    bench_start(&start);
+    xml = gvir_config_object_to_xml(GVIR_CONFIG_OBJECT(gvir_designer_domain_get_config(design)));
+    bench_stat_add(&stats[OP_TO_XML], &start);
+    g_free(xml);
+
+    bench_start(&start);
+    g_object_unref(design);
+    bench_stat_add(&stats[OP_FINALIZE], &start);
+
+    bench_stat_add(&stats[OP_DESIGN], &design_start);
+}
+
+
+int
+main(int argc, char **argv)
+{
+    static gint iterations = 200;
+    static gint max_scale = 16;
+    static gint n_disks = 4;
+    static gint n_oses = 20;
+    static gint derives_depth = 4;
+    static gint n_platforms = 4;
+    static gint n_devices_per_class = 8;
+    static gint n_drivers = 2;
+    static gint n_deployments = 8;
+    GOptionEntry entries[] = {
+        { "iterations", 'i', 0, G_OPTION_ARG_INT, &iterations,
+          "number of designs per database size", "N" },
+        { "max-scale", 's', 0, G_OPTION_ARG_INT, &max_scale,
+          "largest database scale factor, scales double from 1", "N" },
+        { "disks", 'd', 0, G_OPTION_ARG_INT, &n_disks,
+          "number of disks added to each design", "N" },
+        { "oses", 0, 0, G_OPTION_ARG_INT, &n_oses,
+          "number of OSes at scale 1", "N" },
+        { "derives-depth", 0, 0, G_OPTION_ARG_INT, &derives_depth,
+          "length of derives-from chains at scale 1", "N" },
+        { "platforms", 0, 0, G_OPTION_ARG_INT, &n_platforms,
+          "number of platforms at scale 1", "N" },
+        { "devices", 0, 0, G_OPTION_ARG_INT, &n_devices_per_class,
+          "number of devices per class at scale 1", "N" },
+        { "drivers", 0, 0, G_OPTION_ARG_INT, &n_drivers,
+          "number of drivers per OS at scale 1", "N" },
+        { "deployments", 0, 0, G_OPTION_ARG_INT, &n_deployments,
+          "number of deployments at scale 1", "N" },
+        { NULL }
+    };
+    GOptionContext *context;
+    GError *error = NULL;
+    GVirConfigCapabilities *caps;
+    BenchOsinfoDbParams base;
+    guint scale;
+
+    if (!gvir_designer_init_check(&argc, &argv, NULL))
+        return EXIT_FAILURE;
+
+    context = g_option_context_new("- measure design latency versus libosinfo database size");
+    g_option_context_add_main_entries(context, entries, NULL);
+    if (!g_option_context_parse(context, &argc, &argv, &error)) {
+        g_printerr("option parsing failed: %s\n", error->message);
+        g_option_context_free(context);
+        return EXIT_FAILURE;
+    }
+    g_option_context_free(context);
+
+    if (iterations <= 0 || max_scale <= 0 || n_disks <= 0 ||
+        n_oses <= 0 || derives_depth <= 0 || n_platforms <= 0 ||
+        n_devices_per_class <= 0 || n_drivers <= 0 || n_deployments <= 0) {
+        g_printerr("all options must be positive\n");
+        return EXIT_FAILURE;
+    }
+
+    base.n_oses = n_oses;
+    base.derives_depth = derives_depth;
+    base.n_platforms = n_platforms;
+    base.n_devices_per_class = n_devices_per_class;
+    base.n_drivers = n_drivers;
+    base.n_deployments = n_deployments;
+
+    caps = bench_capabilities_new();
+
+    bench_report_header();
+    for (scale = 1; scale <= (guint)max_scale; scale *= 2) {
+        BenchOsinfoDbParams params;
+        BenchStat build = { "db_build", 0, 0 };
+        BenchStat stats[OP_LAST];
+        BenchOsinfoDb *bdb;
+        gchar *variant;
+        BenchStart start;
+        guint i;
+
+        memset(stats, 0, sizeof(stats));
+        for (i = 0; i < OP_LAST; i++)
+            stats[i].op = op_names[i];
+
+        bench_osinfo_db_params_scale(&params, &base, scale);
+
+        bench_start(&start);
+        bdb = bench_osinfo_db_new(&params);
+        bench_stat_add(&build, &start);
+
+        for (i = 0; i < (guint)iterations; i++)
+            bench_design_once(bdb, caps, n_disks, stats);
+
+        variant = g_strdup_printf("x%u", scale);
+        bench_report(BENCH_SUITE, variant, &build);
+        for (i = 0; i < OP_LAST; i++)
+            bench_report(BENCH_SUITE, variant, &stats[i]);
+        g_free(variant);
+
+        bench_osinfo_db_free(bdb);
+    }
+
+    g_object_unref(caps);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,317 @@
+/*
+ * bench-osinfo-gen.c: synthetic libosinfo database generator
+ *
+ * Copyright (C) 2026 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#include <config.h>
+
+#include "bench-osinfo-gen.h"
+
+typedef struct {
+    const char *class;
+    /* device names understood by libvirt-designer, cycled through */
+    const char * const *names;
+    /* real device ID appended last to the class so that lookups by ID
+     * have to scan the whole list */
+    const char *real_id;
+    const char *real_name;
+} BenchDeviceClass;
+
+static const char * const bench_audio_names[] = { "ac97", "ich6", "es1370", "sb16", NULL };
+static const char * const bench_block_names[] = { "ide", "ahci", "lsilogic", NULL };
+static const char * const bench_network_names[] = { "e1000", "rtl8139", "ne2k_pci", NULL };
+static const char * const bench_video_names[] = { "cirrus", "vga", "qxl", "vmvga", NULL };
+static const char * const bench_input_names[] = { "ps2", "usbtablet", NULL };
+
+static const BenchDeviceClass bench_device_classes[] = {
+    { "audio", bench_audio_names, NULL, NULL },
+    { "block", bench_block_names,
+      "http://pciids.sourceforge.net/v2.2/pci.ids/1af4/1001", "virtio-block" },
+    { "network", bench_network_names,
+      "http://pciids.sourceforge.net/v2.2/pci.ids/1af4/1000", "virtio-net" },
+    { "video", bench_video_names, NULL, NULL },
+    { "input", bench_input_names,
+      "http://pciids.sourceforge.net/v2.2/pci.ids/1af4/1003", "virtio-console" },
+};
+
+#define BENCH_N_DEVICE_CLASSES G_N_ELEMENTS(bench_device_classes)
+
+
+void
+bench_osinfo_db_params_scale(BenchOsinfoDbParams *params,
+                             const BenchOsinfoDbParams *base,
+                             guint scale)
+{
+    params->n_oses = base->n_oses * scale;
+    /* chains get longer with the square root of the scale, a deeper
+     * chain is much more expensive than a wider database */
+    params->derives_depth = MAX(1, base->derives_depth);
+    while ((params->derives_depth * params->derives_depth) <
+           (base->derives_depth * base->derives_depth * scale))
+        params->derives_depth++;
+    params->n_platforms = base->n_platforms * scale;
+    params->n_devices_per_class = base->n_devices_per_class * scale;
+    params->n_drivers = base->n_drivers * scale;
+    params->n_deployments = base->n_deployments * scale;
+}
+
+
+static OsinfoDevice *
+bench_osinfo_device_new(OsinfoDb *db,
+                        const char *id,
+                        const char *class,
+                        const char *name)
+{
+    OsinfoDevice *dev = osinfo_device_new(id);
+
+    osinfo_entity_set_param(OSINFO_ENTITY(dev), OSINFO_DEVICE_PROP_CLASS, class);
+    osinfo_entity_set_param(OSINFO_ENTITY(dev), OSINFO_DEVICE_PROP_NAME, name);
+    osinfo_db_add_device(db, dev);
+
+    return dev;
+}
+
+
+static GPtrArray *
+bench_osinfo_db_add_devices(OsinfoDb *db,
+                            const BenchOsinfoDbParams *params,
+                            OsinfoDevice **preferred)
+{
+    GPtrArray *devices = g_ptr_array_new_with_free_func(g_object_unref);
+    guint i, j;
+
+    for (i = 0; i < BENCH_N_DEVICE_CLASSES; i++) {
+        const BenchDeviceClass *cls = &bench_device_classes[i];
+        guint n_names = g_strv_length((gchar **)cls->names);
+
+        preferred[i] = NULL;
+
+        for (j = 0; j < params->n_devices_per_class; j++) {
+            gchar *id = g_strdup_printf("http://bench.libvirt.org/device/%s/%u",
+                                        cls->class, j);
+
+            preferred[i] = bench_osinfo_device_new(db, id, cls->class,
+                                                   cls->names[j % n_names]);
+            g_ptr_array_add(devices, preferred[i]);
+            g_free(id);
+        }
+
+        if (cls->real_id) {
+            preferred[i] = bench_osinfo_device_new(db, cls->real_id,
+                                                   cls->class,
+                                                   cls->real_name);
+            g_ptr_array_add(devices, preferred[i]);
+        }
+    }
+
+    return devices;
+}
+
+
+static void
+bench_osinfo_os_add_resources(OsinfoOs *os,
+                              guint seed)
+{
+    OsinfoResources *res;
+
+    res = osinfo_resources_new("http://bench.libvirt.org/resources/minimum",
+                               "all");
+    osinfo_resources_set_n_cpus(res, 1);
+    osinfo_resources_set_ram(res, (gint64)(256 + (seed % 4) * 128) * 1024 * 1024);
+    osinfo_os_add_minimum_resources(os, res);
+    g_object_unref(res);
+
+    res = osinfo_resources_new("http://bench.libvirt.org/resources/recommended",
+                               "x86_64");
+    osinfo_resources_set_n_cpus(res, 2 + (seed % 3));
+    osinfo_resources_set_ram(res, (gint64)(1024 + (seed % 4) * 512) * 1024 * 1024);
+    osinfo_os_add_recommended_resources(os, res);
+    g_object_unref(res);
+}
+
+
+static void
+bench_osinfo_os_add_drivers(OsinfoOs *os,
+                            guint os_idx,
+                            GPtrArray *devices,
+                            const BenchOsinfoDbParams *params,
+                            GPtrArray *driver_ids)
+{
+    guint i;
+
+    for (i = 0; i < params->n_drivers; i++) {
+        OsinfoDeviceDriver *driver;
+        OsinfoDeviceList *driver_devices;
+        gchar *id = g_strdup_printf("http://bench.libvirt.org/os/%u/driver/%u",
+                                    os_idx, i);
+
+        driver = g_object_new(OSINFO_TYPE_DEVICE_DRIVER, "id", id, NULL);
+        osinfo_entity_set_param(OSINFO_ENTITY(driver),
+                                OSINFO_DEVICE_DRIVER_PROP_ARCHITECTURE,
+                                "x86_64");
+        /* libosinfo has no public setter for the driver device list, but
+         * the list returned here is the driver's own one */
+        driver_devices = osinfo_device_driver_get_devices(driver);
+        if (devices->len > 0)
+            osinfo_list_add(OSINFO_LIST(driver_devices),
+                            OSINFO_ENTITY(g_ptr_array_index(devices,
+                                                            i % devices->len)));
+        osinfo_os_add_device_driver(os, driver);
+        g_object_unref(driver);
+
+        if (driver_ids)
+            g_ptr_array_add(driver_ids, id);
+        else
+            g_free(id);
+    }
+}
+
+
+/**
+ * bench_osinfo_db_new:
+ * @params: sizes of the database to build
+ *
+ * Builds an in-memory #OsinfoDb shaped like the real database: OSes
+ * are grouped in derives-from chains of @params->derives_depth entries
+ * where only the chain head links devices directly, every platform
+ * links all the devices and deployments pair OSes with platforms,
+ * starting from the most expensive pair.
+ *
+ * Returns: (transfer full): the generated database
+ */
+BenchOsinfoDb *
+bench_osinfo_db_new(const BenchOsinfoDbParams *params)
+{
+    BenchOsinfoDb *bdb = g_new0(BenchOsinfoDb, 1);
+    OsinfoDevice *preferred[BENCH_N_DEVICE_CLASSES];
+    GPtrArray *devices;
+    GPtrArray *oses;
+    GPtrArray *platforms;
+    guint n_oses = MAX(1, params->n_oses);
+    guint n_platforms = MAX(1, params->n_platforms);
+    guint depth = MAX(1, params->derives_depth);
+    guint i, j;
+
+    bdb->db = osinfo_db_new();
+    bdb->driver_ids = g_ptr_array_new_with_free_func(g_free);
+
+    devices = bench_osinfo_db_add_devices(bdb->db, params, preferred);
+    oses = g_ptr_array_new_with_free_func(g_object_unref);
+    platforms = g_ptr_array_new_with_free_func(g_object_unref);
+
+    for (i = 0; i < n_platforms; i++) {
+        gchar *id = g_strdup_printf("http://bench.libvirt.org/platform/%u", i);
+        gchar *short_id = g_strdup_printf("bench-hv-%u", i);
+        OsinfoPlatform *platform = osinfo_platform_new(id);
+
+        osinfo_entity_set_param(OSINFO_ENTITY(platform),
+                                OSINFO_PRODUCT_PROP_SHORT_ID, short_id);
+        for (j = 0; j < devices->len; j++)
+            osinfo_platform_add_device(platform,
+                                       OSINFO_DEVICE(g_ptr_array_index(devices, j)));
+        osinfo_db_add_platform(bdb->db, platform);
+        g_ptr_array_add(platforms, platform);
+
+        g_free(short_id);
+        g_free(id);
+    }
+
+    for (i = 0; i < n_oses; i++) {
+        gchar *id = g_strdup_printf("http://bench.libvirt.org/os/%u", i);
+        gchar *short_id = g_strdup_printf("benchos%u", i);
+        OsinfoOs *os = osinfo_os_new(id);
+
+        osinfo_entity_set_param(OSINFO_ENTITY(os),
+                                OSINFO_PRODUCT_PROP_SHORT_ID, short_id);
+
+        if ((i % depth) == 0) {
+            for (j = 0; j < devices->len; j++)
+                osinfo_os_add_device(os,
+                                     OSINFO_DEVICE(g_ptr_array_index(devices, j)));
+        } else {
+            osinfo_product_add_related(OSINFO_PRODUCT(os),
+                                       OSINFO_PRODUCT_RELATIONSHIP_DERIVES_FROM,
+                                       OSINFO_PRODUCT(g_ptr_array_index(oses, i - 1)));
+        }
+
+        bench_osinfo_os_add_resources(os, i);
+        bench_osinfo_os_add_drivers(os, i, devices, params,
+                                    (i == n_oses - 1) ? bdb->driver_ids : NULL);
+
+        osinfo_db_add_os(bdb->db, os);
+        g_ptr_array_add(oses, os);
+
+        g_free(short_id);
+        g_free(id);
+    }
+
+    for (i = 0; i < params->n_deployments; i++) {
+        OsinfoOs *os = g_ptr_array_index(oses, n_oses - 1 - (i % n_oses));
+        OsinfoPlatform *platform =
+            g_ptr_array_index(platforms, n_platforms - 1 - (i % n_platforms));
+        gchar *id = g_strdup_printf("http://bench.libvirt.org/deployment/%u", i);
+        OsinfoDeployment *deployment = osinfo_deployment_new(id, os, platform);
+
+        /* the preferred device of each class is the last one */
+        for (j = 0; j < BENCH_N_DEVICE_CLASSES; j++) {
+            OsinfoDeviceLink *dev_link;
+
+            if (preferred[j] == NULL)
+                continue;
+
+            dev_link = osinfo_deployment_add_device(deployment, preferred[j]);
+            if (g_str_equal(bench_device_classes[j].class, "network")) {
+                const char *name = osinfo_device_get_name(preferred[j]);
+
+                /* the NIC model is taken from the link driver */
+                if (g_str_equal(name, "virtio-net"))
+                    name = "virtio";
+                osinfo_entity_set_param(OSINFO_ENTITY(dev_link),
+                                        OSINFO_DEVICELINK_PROP_DRIVER,
+                                        name);
+            }
+        }
+
+        osinfo_db_add_deployment(bdb->db, deployment);
+        g_object_unref(deployment);
+        g_free(id);
+    }
+
+    bdb->os = g_object_ref(g_ptr_array_index(oses, n_oses - 1));
+    bdb->platform = g_object_ref(g_ptr_array_index(platforms, n_platforms - 1));
+
+    g_ptr_array_unref(platforms);
+    g_ptr_array_unref(oses);
+    g_ptr_array_unref(devices);
+
+    return bdb;
+}
+
+
+void
+bench_osinfo_db_free(BenchOsinfoDb *bdb)
+{
+    if (bdb == NULL)
+        return;
+
+    g_object_unref(bdb->os);
+    g_object_unref(bdb->platform);
+    g_object_unref(bdb->db);
+    g_ptr_array_unref(bdb->driver_ids);
+    g_free(bdb);
+}
@@ -0,0 +1,65 @@
+/*
+ * bench-osinfo-gen.h: synthetic libosinfo database generator
+ *
+ * Copyright (C) 2026 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __BENCH_OSINFO_GEN_H__
+#define __BENCH_OSINFO_GEN_H__
+
+#include <osinfo/osinfo.h>
+
+G_BEGIN_DECLS
+
+typedef struct _BenchOsinfoDbParams BenchOsinfoDbParams;
+typedef struct _BenchOsinfoDb BenchOsinfoDb;
+
+struct _BenchOsinfoDbParams
+{
+    guint n_oses;               /* total number of OSes */
+    guint derives_depth;        /* length of each derives-from chain */
+    guint n_platforms;
+    guint n_devices_per_class;
+    guint n_drivers;            /* device drivers attached to each OS */
+    guint n_deployments;
+};
+
+struct _BenchOsinfoDb
+{
+    OsinfoDb *db;
+
+    /* The OS at the tail of the last derives-from chain and the last
+     * platform: resolving devices for this pair walks the longest
+     * chain and the largest lists. */
+    OsinfoOs *os;
+    OsinfoPlatform *platform;
+
+    /* IDs of the drivers attached to @os, for
+     * gvir_designer_domain_add_driver() */
+    GPtrArray *driver_ids;
+};
+
+void bench_osinfo_db_params_scale(BenchOsinfoDbParams *params,
+                                  const BenchOsinfoDbParams *base,
+                                  guint scale);
+
+BenchOsinfoDb *bench_osinfo_db_new(const BenchOsinfoDbParams *params);
+void bench_osinfo_db_free(BenchOsinfoDb *bdb);
+
+G_END_DECLS
+
+#endif /* __BENCH_OSINFO_GEN_H__ */
@@ -0,0 +1,144 @@
+#!/bin/sh
+#
+# bench-virt-designer.sh: whole virt-designer runs against test:///default
+#
+# Copyright (C) 2026 Red Hat, Inc.
+#
+# This library is free software; you can redistribute it and/or
+# modify it under the terms of the GNU Lesser General Public
+# License as published by the Free Software Foundation; either
+# version 2.1 of the License, or (at your option) any later version.
+#
+# This library is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+# Lesser General Public License for more details.
+#
+# You should have received a copy of the GNU Lesser General Public
+# License along with this library. If not, see
+# <http://www.gnu.org/licenses/>.
+#
+# Runs virt-designer for every OS and device set below and prints, per
+# combination, the mean wall time, the largest peak RSS and the mean
+# time of each phase reported by virt-designer --timing:
+#
+#   # key	value	runs
+#   virt-designer/fedora20/desktop/wall_us	41230	5
+#
+# The following environment variables tune the run:
+#
+#   VIRT_DESIGNER  path of the binary, defaults to examples/virt-designer
+#   CONNECT        libvirt URI, defaults to test:///default
+#   PLATFORM       libosinfo platform, defaults to the first known one as
+#                  the test driver does not map to any platform
+#   OSES           space separated OS short IDs or IDs
+#   RUNS           runs per combination, 5 by default
+
+srcdir=$(dirname "$0")
+
+VIRT_DESIGNER=${VIRT_DESIGNER:-$srcdir/../examples/virt-designer}
+CONNECT=${CONNECT:-test:///default}
+OSES=${OSES:-"fedora20 rhel7.0 debian8 win7 win2k12r2"}
+RUNS=${RUNS:-5}
+
+# name:options, disks are left out as the test driver virt type has no
+# disk driver
+DEVICE_SETS="
+bare:
+minimal:-r minimal
+network:-i default -i default,link=down
+vnc:-i default -g vnc
+desktop:-i default -g spice -u -s
+"
+
+if test ! -x "$VIRT_DESIGNER"; then
+    echo "$0: $VIRT_DESIGNER not found, build with --enable-examples or set VIRT_DESIGNER" >&2
+    exit 2
+fi
+
+if test -z "$PLATFORM"; then
+    PLATFORM=$("$VIRT_DESIGNER" --list-platform | sed -n '3p')
+    if test -z "$PLATFORM"; then
+        echo "$0: libosinfo knows no platform, set PLATFORM" >&2
+        exit 2
+    fi
+fi
+
+if test -x /usr/bin/time; then
+    TIME="/usr/bin/time -f %M -o"
+else
+    TIME=
+fi
+
+tmpdir=$(mktemp -d) || exit 2
+trap 'rm -rf "$tmpdir"' EXIT
+
+# Runs virt-designer once and appends 'wall_us maxrss_kib libvirt_us
+# libosinfo_us designer_us xml_us' to $tmpdir/samples
+run_once() {
+    start=$(date +%s%N)
+    if test -n "$TIME"; then
+        $TIME "$tmpdir/rss" "$VIRT_DESIGNER" --timing -c "$CONNECT" \
+            -p "$PLATFORM" -o "$1" $2 > /dev/null 2> "$tmpdir/stderr"
+    else
+        "$VIRT_DESIGNER" --timing -c "$CONNECT" \
+            -p "$PLATFORM" -o "$1" $2 > /dev/null 2> "$tmpdir/stderr"
+    fi
+    status=$?
+    end=$(date +%s%N)
+
+    if test $status != 0; then
+        return 1
+    fi
+
+    if test -n "$TIME"; then
+        rss=$(tail -n 1 "$tmpdir/rss")
+    else
+        rss=-
+    fi
+
+    awk -F '\t' -v wall=$(( (end - start) / 1000 )) -v rss="$rss" '
+        /^#/ { next }
+        NF == 2 { phase[$1] = $2 }
+        END {
+            print wall, rss, phase["libvirt"], phase["libosinfo"],
+                  phase["designer"], phase["xml"]
+        }' "$tmpdir/stderr" >> "$tmpdir/samples"
+}
+
+printf '# key\tvalue\truns\n'
+
+for os in $OSES; do
+    echo "$DEVICE_SETS" | while IFS=: read -r name options; do
+        test -z "$name" && continue
+
+        : > "$tmpdir/samples"
+        i=0
+        while test $i -lt "$RUNS"; do
+            if ! run_once "$os" "$options"; then
+                echo "$0: $os/$name failed:" >&2
+                cat "$tmpdir/stderr" >&2
+                break
+            fi
+            i=$((i + 1))
+        done
+        test -s "$tmpdir/samples" || continue
+
+        awk -v key="virt-designer/$os/$name" '
+            {
+                n++
+                wall += $1
+                if ($2 != "-" && $2 > rss) rss = $2
+                libvirt += $3; libosinfo += $4; designer += $5; xml += $6
+            }
+            END {
+                printf "%s/wall_us\t%d\t%d\n", key, wall / n, n
+                if (rss)
+                    printf "%s/maxrss_kib\t%d\t%d\n", key, rss, n
+                printf "%s/libvirt_us\t%d\t%d\n", key, libvirt / n, n
+                printf "%s/libosinfo_us\t%d\t%d\n", key, libosinfo / n, n
+                printf "%s/designer_us\t%d\t%d\n", key, designer / n, n
+                printf "%s/xml_us\t%d\t%d\n", key, xml / n, n
+            }' "$tmpdir/samples"
+    done
+done
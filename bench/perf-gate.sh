@@ -0,0 +1,112 @@
+#!/bin/sh
+#
+# perf-gate.sh: compare benchmark results against a baseline
+#
+# Copyright (C) 2026 Red Hat, Inc.
+#
+# This library is free software; you can redistribute it and/or
+# modify it under the terms of the GNU Lesser General Public
+# License as published by the Free Software Foundation; either
+# version 2.1 of the License, or (at your option) any later version.
+#
+# This library is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+# Lesser General Public License for more details.
+#
+# You should have received a copy of the GNU Lesser General Public
+# License along with this library. If not, see
+# <http://www.gnu.org/licenses/>.
+#
+# Both files use the benchmark output format:
+#
+#   key <TAB> ns/op <TAB> count <TAB> allocs/op
+#
+# An operation regresses when its time per operation grows by more than
+# NS-THRESHOLD percent (and by at least PERF_GATE_MIN_NS nanoseconds,
+# short operations are too noisy otherwise), or when its allocations
+# per operation grow by more than ALLOC-THRESHOLD percent. A baseline
+# time of '-' only gates on allocations, which do not depend on the
+# machine. Operations missing from either file are listed but never fail
+# the gate, a baseline without any entry, or one that shares no
+# operation with the results, always fails it.
+
+if test $# -lt 2 || test $# -gt 4; then
+    echo "usage: $0 BASELINE RESULTS [NS-THRESHOLD [ALLOC-THRESHOLD]]" >&2
+    exit 2
+fi
+
+baseline=$1
+results=$2
+ns_threshold=${3:-20}
+alloc_threshold=${4:-5}
+min_ns=${PERF_GATE_MIN_NS:-500}
+
+for f in "$baseline" "$results"; do
+    if test ! -r "$f"; then
+        echo "$0: cannot read $f" >&2
+        exit 2
+    fi
+done
+
+exec awk -F '\t' \
+    -v baseline="$baseline" \
+    -v ns_threshold="$ns_threshold" \
+    -v alloc_threshold="$alloc_threshold" \
+    -v min_ns="$min_ns" '
+/^#/ || NF < 2 { next }
+
+FILENAME == baseline {
+    n_base++
+    base_ns[$1] = $2
+    base_allocs[$1] = $4
+    next
+}
+
+{
+    seen[$1] = 1
+    if (!($1 in base_ns)) {
+        printf "NEW         %s\n", $1
+        added++
+        next
+    }
+    checked++
+
+    if (base_ns[$1] != "-") {
+        limit = base_ns[$1] * (1 + ns_threshold / 100)
+        if ($2 > limit && $2 - base_ns[$1] >= min_ns) {
+            printf "REGRESSION  %s: %d ns/op, baseline %d (+%.1f%%)\n",
+                   $1, $2, base_ns[$1],
+                   ($2 - base_ns[$1]) * 100 / base_ns[$1]
+            failed++
+        }
+    }
+
+    if ($4 == "" || $4 == "-" || base_allocs[$1] == "" || base_allocs[$1] == "-")
+        next
+    limit = base_allocs[$1] * (1 + alloc_threshold / 100)
+    if ($4 > limit) {
+        printf "REGRESSION  %s: %d allocs/op, baseline %d\n",
+               $1, $4, base_allocs[$1]
+        failed++
+    }
+}
+
+END {
+    for (key in base_ns) {
+        if (!(key in seen)) {
+            printf "MISSING     %s\n", key
+        }
+    }
+    printf "%d operations checked, %d regressions, %d not in the baseline\n",
+           checked, failed, added
+    if (n_base == 0) {
+        print "FAILED      the baseline has no entries, run make refresh-baseline"
+        exit 1
+    }
+    if (checked == 0) {
+        print "FAILED      no operation of the baseline was measured"
+        exit 1
+    }
+    exit failed > 0
+}' "$baseline" "$results"
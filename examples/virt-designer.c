@@ -39,6 +39,25 @@ GList *floppy_str_list = NULL;
 GList *iface_str_list = NULL;
 OsinfoDb *db = NULL;
 
+/* Time spent in each phase, printed with --timing */
+enum {
+    TIMING_LIBVIRT,
+    TIMING_LIBOSINFO,
+    TIMING_DESIGNER,
+    TIMING_XML,
+    TIMING_LAST
+};
+
+static const char *timing_names[TIMING_LAST] = {
+    "libvirt",
+    "libosinfo",
+    "designer",
+    "xml",
+};
+
+gint64 timing_us[TIMING_LAST];
+gint64 timing_last;
+
 #define print_error(...) \
     print_error_impl(__FUNCTION__, __LINE__, __VA_ARGS__)
 
@@ -537,6 +556,26 @@ guess_platform_from_connect(GVirConnection *conn)
     return ret;
 }
 
+/* Accounts the time since the previous call to @phase */
+static void
+timing_account(int phase)
+{
+    gint64 now = g_get_monotonic_time();
+
+    timing_us[phase] += now - timing_last;
+    timing_last = now;
+}
+
+static void
+print_timing(void)
+{
+    unsigned int i;
+
+    fprintf(stderr, "# phase\tus\n");
+    for (i = 0; i < TIMING_LAST; i++)
+        fprintf(stderr, "%s\t%" G_GINT64_FORMAT "\n", timing_names[i], timing_us[i]);
+}
+
 #define CHECK_ERROR \
     if (error) {                            \
         print_error("%s", error->message);  \
@@ -564,6 +603,7 @@ main(int argc, char *argv[])
     static gboolean enable_smartcard;
     static gboolean enable_usb;
     static char *resources_str = NULL;
+    static gboolean show_timing;
     GVirDesignerDomainResources resources;
     GOptionContext *context = NULL;
     unsigned int i;
@@ -598,6 +638,8 @@ main(int argc, char *argv[])
             "add USB redirection to the VM.", NULL},
         {"resources", 'r', 0, G_OPTION_ARG_STRING, &resources_str,
             "Set minimal or recommended values for cpu count and RAM amount", "{minimal|recommended}"},
+        {"timing", 0, 0, G_OPTION_ARG_NONE, &show_timing,
+            "print the time spent in libvirt, libosinfo, the designer and XML formatting", NULL},
         {NULL}
     };
 
@@ -611,12 +653,15 @@ main(int argc, char *argv[])
         return EXIT_FAILURE;
     }
 
+    timing_last = g_get_monotonic_time();
+
     conn = gvir_connection_new(connect_uri);
     gvir_connection_open(conn, NULL, &error);
     CHECK_ERROR;
 
     caps = gvir_connection_get_capabilities(conn, &error);
     CHECK_ERROR;
+    timing_account(TIMING_LIBVIRT);
 
     if (os_str) {
         os = find_os(os_str);
@@ -643,6 +688,7 @@ main(int argc, char *argv[])
         print_error("Platform was not specified or could not be guessed");
         goto cleanup;
     }
+    timing_account(TIMING_LIBOSINFO);
 
     domain = gvir_designer_domain_new(db, os, platform, caps);
 
@@ -714,13 +760,18 @@ main(int argc, char *argv[])
     g_list_foreach(floppy_str_list, add_floppy, domain);
 
     g_list_foreach(iface_str_list, add_iface, domain);
+    timing_account(TIMING_DESIGNER);
 
     config = gvir_designer_domain_get_config(domain);
     xml = gvir_config_object_to_xml(GVIR_CONFIG_OBJECT(config));
+    timing_account(TIMING_XML);
 
     g_printf("%s\n", xml);
     g_free(xml);
 
+    if (show_timing)
+        print_timing();
+
     ret = EXIT_SUCCESS;
 
 cleanup:
@@ -835,6 +886,14 @@ Add USB controllers and setup USB redirection in the VM configuration.
 Set I<minimal> or I<recommended> resources on the domain XML. By default,
 the I<recommended> is used.
 
+=item --timing
+
+Once the XML is printed, print on standard error how many microseconds
+were spent talking to libvirt (connection and capabilities), looking up
+the OS and platform in libosinfo (including loading its database),
+designing the domain and formatting the XML. The output has one
+tab separated line per phase.
+
 =back
 
 Usually, both B<--os> and B<--platform> are required as they are needed to
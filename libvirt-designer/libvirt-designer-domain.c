@@ -24,6 +24,7 @@
  */
 
 #include <config.h>
+#include <string.h>
 #include <sys/utsname.h>
 
 #include "libvirt-designer/libvirt-designer.h"
@@ -43,12 +44,53 @@ struct _GVirDesignerDomainPrivate
     OsinfoDeployment *deployment;
     OsinfoDeviceDriverList *drivers;
 
-    /* next disk targets */
-    unsigned int ide;
-    unsigned int virtio;
-    unsigned int sata;
+    /* target prefix ("hd", "vd", ...) -> GVirDesignerDiskTargets */
+    GHashTable *disk_targets;
+
+    /* Only ever set to TRUE, devices can be added to the config behind
+     * our back so a FALSE value still needs a look at the config */
+    gboolean has_spice_channel;
+    gboolean has_usb_controller;
+    gboolean has_virtio_scsi_controller;
+
+    /* index of the virtio-scsi controller, other models may be there */
+    guint virtio_scsi_index;
+    /* disks, not cdroms or floppies, on a virtio-blk bus */
+    guint n_virtio_disks;
+    /* 0 disables switching from virtio-blk to virtio-scsi */
+    guint virtio_scsi_threshold;
+    GVirDesignerDomainDiskProfile disk_profile;
+    GVirDesignerDomainThinProvisioning thin_provisioning;
+    guint n_iothreads;
+    /* round-robin position, 0 based */
+    guint next_iothread;
+    /* KiB, 0 without hugepages */
+    guint hugepage_size;
+    GVirDesignerDomainDisplayLocality display_locality;
+    GVirDesignerDomainUsbMode usb_mode;
+    gchar *machine_type;
+    gboolean headless;
+    /* the qemu-xhci controller we added, its ports follow n_usb_redirs */
+    GVirConfigDomainControllerUsb *xhci_controller;
+    guint n_usb_redirs;
+    /* 0 sizes virtio-net queues after the vCPU count */
+    guint nic_queues;
 };
 
+/* A host logical CPU, from the NUMA topology in the capabilities */
+typedef struct {
+    guint id;
+    guint cell;
+    guint socket;
+    guint core;
+} GVirDesignerHostCpu;
+
+/* Disk target indexes in use for one target prefix */
+typedef struct {
+    GArray *used;       /* bitmap, 32 indexes per guint32 */
+    guint first_free;   /* no index below this one is free */
+} GVirDesignerDiskTargets;
+
 G_DEFINE_TYPE(GVirDesignerDomain, gvir_designer_domain, G_TYPE_OBJECT);
 
 #define GVIR_DESIGNER_DOMAIN_ERROR gvir_designer_domain_error_quark()
@@ -57,6 +99,8 @@ typedef enum {
     GVIR_DESIGNER_DOMAIN_NIC_TYPE_BRIDGE,
     GVIR_DESIGNER_DOMAIN_NIC_TYPE_NETWORK,
     GVIR_DESIGNER_DOMAIN_NIC_TYPE_USER,
+    GVIR_DESIGNER_DOMAIN_NIC_TYPE_DIRECT,
+    GVIR_DESIGNER_DOMAIN_NIC_TYPE_VHOSTUSER,
     /* add new type here */
 } GVirDesignerDomainNICType;
 
@@ -75,6 +119,22 @@ error_is_set(GError **error)
 static const char GVIR_DESIGNER_SPICE_CHANNEL_NAME[] = "com.redhat.spice.0";
 static const char GVIR_DESIGNER_SPICE_CHANNEL_DEVICE_ID[] = "http://pciids.sourceforge.net/v2.2/pci.ids/1af4/1003";
 static const char GVIR_DESIGNER_VIRTIO_BLOCK_DEVICE_ID[] = "http://pciids.sourceforge.net/v2.2/pci.ids/1af4/1001";
+static const char * const GVIR_DESIGNER_VIRTIO_SCSI_DEVICE_IDS[] = {
+    "http://pciids.sourceforge.net/v2.2/pci.ids/1af4/1004",
+    "http://pciids.sourceforge.net/v2.2/pci.ids/1af4/1048",
+};
+static const char GVIR_DESIGNER_VIRTIO_INPUT_DEVICE_ID[] = "http://pciids.sourceforge.net/v2.2/pci.ids/1af4/1052";
+static const char GVIR_DESIGNER_VIRTIO1_NET_DEVICE_ID[] = "http://pciids.sourceforge.net/v2.2/pci.ids/1af4/1041";
+static const char GVIR_DESIGNER_QEMU_XHCI_DEVICE_ID[] = "http://pciids.sourceforge.net/v2.2/pci.ids/1b36/000d";
+/* qemu-xhci defaults to 4 ports and libvirt accepts up to 15 */
+static const guint GVIR_DESIGNER_XHCI_MIN_PORTS = 4;
+static const guint GVIR_DESIGNER_XHCI_MAX_PORTS = 15;
+/* Each queue pair gets its own vhost-net worker, past this the extra
+ * guest interrupts cost more than the added parallelism buys */
+static const guint GVIR_DESIGNER_NIC_MAX_QUEUES = 8;
+/* Disk target indexes per prefix, "a" to "zzz", far more disks than
+ * any bus takes while keeping the bitmap of used targets small */
+static const guint GVIR_DESIGNER_DISK_TARGET_MAX = 18278;
 
 enum {
     PROP_0,
@@ -135,6 +195,12 @@ gvir_designer_domain_set_property(GObject *object,
     GVirDesignerDomainPrivate *priv = design->priv;
 
     switch (prop_id) {
+    case PROP_CONFIG:
+        if (priv->config)
+            g_object_unref(priv->config);
+        priv->config = g_value_dup_object(value);
+        break;
+
     case PROP_OSINFO_DB:
         if (priv->osinfo_db)
             g_object_unref(priv->osinfo_db);
@@ -180,16 +246,23 @@ gvir_designer_domain_finalize(GObject *object)
         g_object_unref(priv->osinfo_db);
     if (priv->drivers)
         g_object_unref(priv->drivers);
+    g_hash_table_unref(priv->disk_targets);
+    if (priv->xhci_controller)
+        g_object_unref(priv->xhci_controller);
+    g_free(priv->machine_type);
 
     G_OBJECT_CLASS(gvir_designer_domain_parent_class)->finalize(object);
 }
 
 
+static void gvir_designer_domain_constructed(GObject *object);
+
 static void
 gvir_designer_domain_class_init(GVirDesignerDomainClass *klass)
 {
     GObjectClass *object_class = G_OBJECT_CLASS(klass);
 
+    object_class->constructed = gvir_designer_domain_constructed;
     object_class->finalize = gvir_designer_domain_finalize;
 
     object_class->get_property = gvir_designer_domain_get_property;
@@ -202,6 +275,8 @@ gvir_designer_domain_class_init(GVirDesignerDomainClass *klass)
                                                         "Domain config",
                                                         GVIR_CONFIG_TYPE_DOMAIN,
                                                         G_PARAM_READABLE |
+                                                        G_PARAM_WRITABLE |
+                                                        G_PARAM_CONSTRUCT_ONLY |
                                                         G_PARAM_STATIC_STRINGS));
 
     g_object_class_install_property(object_class,
@@ -347,6 +422,107 @@ gvir_designer_domain_get_device_by_type(GVirDesignerDomain *design,
 }
 
 
+/* libosinfo names all Windows releases win<something> */
+static gboolean
+gvir_designer_domain_is_windows(GVirDesignerDomain *design)
+{
+    const gchar *short_id;
+
+    if (design->priv->os == NULL)
+        return FALSE;
+
+    short_id = osinfo_product_get_short_id(OSINFO_PRODUCT(design->priv->os));
+
+    return short_id != NULL && g_str_has_prefix(short_id, "win");
+}
+
+
+/* Whether the OS version is at least @major.@minor, an OS without a
+ * version is assumed to be recent */
+static gboolean
+gvir_designer_domain_os_version_at_least(GVirDesignerDomain *design,
+                                         guint major,
+                                         guint minor)
+{
+    const gchar *version;
+    gchar *end = NULL;
+    guint64 os_major;
+    guint64 os_minor = 0;
+
+    version = osinfo_product_get_version(OSINFO_PRODUCT(design->priv->os));
+    if (version == NULL)
+        return TRUE;
+
+    os_major = g_ascii_strtoull(version, &end, 10);
+    if (end == version)
+        return TRUE;
+    if (*end == '.')
+        os_minor = g_ascii_strtoull(end + 1, NULL, 10);
+
+    return os_major > major || (os_major == major && os_minor >= minor);
+}
+
+
+/* Adds the @name timer to the clock, or updates it */
+static xmlNodePtr
+gvir_designer_domain_set_timer_present(GVirDesignerDomain *design,
+                                       const char *name,
+                                       gboolean present)
+{
+    xmlNodePtr clock;
+    xmlNodePtr timer;
+
+    clock = gvir_designer_xml_ensure_child(gvir_designer_xml_get_node(GVIR_CONFIG_OBJECT(design->priv->config)),
+                                           "clock");
+    for (timer = clock->children; timer != NULL; timer = timer->next) {
+        if (timer->type == XML_ELEMENT_NODE &&
+            xmlStrEqual(timer->name, (const xmlChar *)"timer") &&
+            gvir_designer_xml_has_attribute_value(timer, "name", name))
+            break;
+    }
+    if (timer == NULL) {
+        timer = gvir_designer_xml_add_child(clock, "timer");
+        gvir_designer_xml_set_attribute(timer, "name", name);
+    }
+    gvir_designer_xml_set_attribute(timer, "present", present ? "yes" : "no");
+
+    return timer;
+}
+
+
+static gboolean
+gvir_designer_domain_is_linux(GVirDesignerDomain *design)
+{
+    if (design->priv->os == NULL)
+        return FALSE;
+
+    return g_strcmp0(osinfo_entity_get_param_value(OSINFO_ENTITY(design->priv->os),
+                                                   "family"),
+                     "linux") == 0;
+}
+
+
+static void
+gvir_designer_domain_setup_paravirt_clock(GVirDesignerDomain *design)
+{
+    if (gvir_config_domain_get_virt_type(design->priv->config) !=
+        GVIR_CONFIG_DOMAIN_VIRT_KVM)
+        return;
+
+    /* Linux reads the time from the shared kvmclock page instead of
+     * trapping on PIT/HPET reads, Windows 7 and later use the Hyper-V
+     * clock. Neither needs the HPET, whose emulation costs wakeups on
+     * idle guests. */
+    if (gvir_designer_domain_is_linux(design)) {
+        gvir_designer_domain_set_timer_present(design, "kvmclock", TRUE);
+        gvir_designer_domain_set_timer_present(design, "hpet", FALSE);
+    } else if (gvir_designer_domain_is_windows(design) &&
+               gvir_designer_domain_os_version_at_least(design, 6, 1)) {
+        gvir_designer_domain_set_timer_present(design, "hpet", FALSE);
+    }
+}
+
+
 static void
 gvir_designer_domain_add_clock(GVirDesignerDomain *design)
 {
@@ -356,14 +532,8 @@ gvir_designer_domain_add_clock(GVirDesignerDomain *design)
 
     clock = gvir_config_domain_clock_new();
     offset = GVIR_CONFIG_DOMAIN_CLOCK_UTC;
-    if (design->priv->os != NULL) {
-        const gchar *short_id;
-
-        short_id = osinfo_product_get_short_id(OSINFO_PRODUCT(design->priv->os));
-        if (short_id != NULL && g_str_has_suffix(short_id, "win")) {
-            offset = GVIR_CONFIG_DOMAIN_CLOCK_LOCALTIME;
-        }
-    }
+    if (gvir_designer_domain_is_windows(design))
+        offset = GVIR_CONFIG_DOMAIN_CLOCK_LOCALTIME;
     gvir_config_domain_clock_set_offset(clock, offset);
 
     timer = GVIR_CONFIG_DOMAIN_TIMER(gvir_config_domain_timer_rtc_new());
@@ -380,6 +550,82 @@ gvir_designer_domain_add_clock(GVirDesignerDomain *design)
 
     gvir_config_domain_set_clock(design->priv->config, clock);
     g_object_unref(G_OBJECT(clock));
+
+    gvir_designer_domain_setup_paravirt_clock(design);
+}
+
+
+static void
+gvir_designer_domain_add_hyperv_feature(xmlNodePtr hyperv,
+                                        const char *name)
+{
+    xmlNodePtr feature;
+
+    feature = gvir_designer_xml_ensure_child(hyperv, name);
+    gvir_designer_xml_set_attribute(feature, "state", "on");
+}
+
+
+/* Windows runs on Hyper-V paravirtual interfaces when it finds them,
+ * rather than on emulated timers and APIC accesses, which all cause
+ * exits. Vista/2008 (NT 6.0) knows the basic ones, 7/2008 R2 (NT 6.1)
+ * the synthetic interrupt controller, timers and reference clock. */
+static void
+gvir_designer_domain_add_hyperv(GVirDesignerDomain *design)
+{
+    xmlNodePtr features;
+    xmlNodePtr hyperv;
+
+    if (gvir_config_domain_get_virt_type(design->priv->config) !=
+        GVIR_CONFIG_DOMAIN_VIRT_KVM ||
+        !gvir_designer_domain_is_windows(design) ||
+        !gvir_designer_domain_os_version_at_least(design, 6, 0))
+        return;
+
+    g_debug("Adding Hyper-V enlightenments");
+
+    features = gvir_designer_xml_ensure_child(gvir_designer_xml_get_node(GVIR_CONFIG_OBJECT(design->priv->config)),
+                                              "features");
+    hyperv = gvir_designer_xml_ensure_child(features, "hyperv");
+    gvir_designer_domain_add_hyperv_feature(hyperv, "relaxed");
+    gvir_designer_domain_add_hyperv_feature(hyperv, "vapic");
+    gvir_designer_domain_add_hyperv_feature(hyperv, "spinlocks");
+    gvir_designer_xml_set_attribute(gvir_designer_xml_get_child(hyperv, "spinlocks"),
+                                    "retries", "8191");
+
+    if (!gvir_designer_domain_os_version_at_least(design, 6, 1))
+        return;
+
+    gvir_designer_domain_add_hyperv_feature(hyperv, "vpindex");
+    gvir_designer_domain_add_hyperv_feature(hyperv, "synic");
+    gvir_designer_domain_add_hyperv_feature(hyperv, "stimer");
+    gvir_designer_domain_add_hyperv_feature(hyperv, "frequencies");
+    /* stimer needs it */
+    gvir_designer_domain_set_timer_present(design, "hypervclock", TRUE);
+}
+
+
+static gboolean
+gvir_designer_domain_channel_is_spice(GVirConfigDomainChannel *channel)
+{
+    GVirConfigDomainChannelTargetType target_type;
+    const char *target_name;
+
+    target_name = gvir_config_domain_channel_get_target_name(channel);
+    if (g_strcmp0(target_name, GVIR_DESIGNER_SPICE_CHANNEL_NAME) != 0)
+        return FALSE;
+
+    /* FIXME could do more sanity checks (check if the channel
+     * source has the 'spicevmc' type)
+     */
+    target_type = gvir_config_domain_channel_get_target_type(channel);
+    if (target_type != GVIR_CONFIG_DOMAIN_CHANNEL_TARGET_VIRTIO) {
+        g_critical("Inconsistent SPICE channel, target type is wrong (%d)",
+                   target_type);
+        return FALSE;
+    }
+
+    return TRUE;
 }
 
 
@@ -388,35 +634,21 @@ gvir_designer_domain_has_spice_channel(GVirDesignerDomain *design)
 {
     GList *devices;
     GList *it;
-    gboolean has_spice = FALSE;
+
+    if (design->priv->has_spice_channel)
+        return TRUE;
 
     devices = gvir_designer_domain_get_device_by_type(design,
                                                       GVIR_CONFIG_TYPE_DOMAIN_CHANNEL);
     for (it = devices; it != NULL; it = it->next) {
-        GVirConfigDomainChannel *channel;
-        const char *target_name;
-        channel = GVIR_CONFIG_DOMAIN_CHANNEL(it->data);
-        target_name = gvir_config_domain_channel_get_target_name(channel);
-        if (g_strcmp0(target_name, GVIR_DESIGNER_SPICE_CHANNEL_NAME) == 0) {
-            /* FIXME could do more sanity checks (check if the channel
-             * source has the 'spicevmc' type)
-             */
-            GVirConfigDomainChannelTargetType target_type;
-            target_type = gvir_config_domain_channel_get_target_type(channel);
-            if (target_type == GVIR_CONFIG_DOMAIN_CHANNEL_TARGET_VIRTIO) {
-                has_spice = TRUE;
-            } else {
-                g_critical("Inconsistent SPICE channel, target type is wrong (%d)",
-                           target_type);
-                has_spice = FALSE;
-            }
-
+        if (gvir_designer_domain_channel_is_spice(GVIR_CONFIG_DOMAIN_CHANNEL(it->data))) {
+            design->priv->has_spice_channel = TRUE;
             break;
         }
     }
     g_list_free_full(devices, g_object_unref);
 
-    return has_spice;
+    return design->priv->has_spice_channel;
 }
 
 
@@ -476,11 +708,80 @@ gvir_designer_domain_add_spice_channel(GVirDesignerDomain *design,
     gvir_config_domain_add_device(design->priv->config,
                                   GVIR_CONFIG_DOMAIN_DEVICE(channel));
     g_object_unref(G_OBJECT(channel));
+    design->priv->has_spice_channel = TRUE;
 
     return TRUE;
 }
 
 
+/**
+ * gvir_designer_domain_set_display_locality:
+ * @design: (transfer none): the domain designer instance
+ * @locality: where the clients of the display are
+ *
+ * Tells how far from the host the clients of the SPICE displays added
+ * from now on are, so that compression trades CPU time for bandwidth
+ * accordingly:
+ *
+ * GVIR_DESIGNER_DOMAIN_DISPLAY_LOCALITY_LOCAL, the default, is for
+ * clients on the host itself, images are sent uncompressed.
+ *
+ * GVIR_DESIGNER_DOMAIN_DISPLAY_LOCALITY_LAN compresses images
+ * losslessly and streams the regions which look like video.
+ *
+ * GVIR_DESIGNER_DOMAIN_DISPLAY_LOCALITY_WAN also lets SPICE turn to
+ * JPEG and zlib when the bandwidth is low, and streams every region
+ * which changes often.
+ */
+void
+gvir_designer_domain_set_display_locality(GVirDesignerDomain *design,
+                                          GVirDesignerDomainDisplayLocality locality)
+{
+    g_return_if_fail(GVIR_DESIGNER_IS_DOMAIN(design));
+
+    design->priv->display_locality = locality;
+}
+
+
+static void
+gvir_designer_domain_setup_spice_compression(GVirDesignerDomain *design,
+                                             GVirConfigDomainGraphicsSpice *spice)
+{
+    xmlNodePtr node;
+    const char *lossy;
+    const char *streaming;
+
+    switch (design->priv->display_locality) {
+    case GVIR_DESIGNER_DOMAIN_DISPLAY_LOCALITY_LAN:
+        lossy = "never";
+        streaming = "filter";
+        break;
+    case GVIR_DESIGNER_DOMAIN_DISPLAY_LOCALITY_WAN:
+        lossy = "auto";
+        streaming = "all";
+        break;
+    case GVIR_DESIGNER_DOMAIN_DISPLAY_LOCALITY_LOCAL:
+    default:
+        /* compressing costs more than copying to a local client */
+        gvir_config_domain_graphics_spice_set_image_compression(spice,
+                                                                GVIR_CONFIG_DOMAIN_GRAPHICS_SPICE_IMAGE_COMPRESSION_OFF);
+        return;
+    }
+
+    gvir_config_domain_graphics_spice_set_image_compression(spice,
+                                                            GVIR_CONFIG_DOMAIN_GRAPHICS_SPICE_IMAGE_COMPRESSION_AUTO_GLZ);
+
+    /* libvirt-gconfig only knows about image compression */
+    node = gvir_designer_xml_get_node(GVIR_CONFIG_OBJECT(spice));
+    gvir_designer_xml_set_attribute(gvir_designer_xml_ensure_child(node, "jpeg"),
+                                    "compression", lossy);
+    gvir_designer_xml_set_attribute(gvir_designer_xml_ensure_child(node, "zlib"),
+                                    "compression", lossy);
+    gvir_designer_xml_set_attribute(gvir_designer_xml_ensure_child(node, "streaming"),
+                                    "mode", streaming);
+}
+
+
 static GVirConfigDomainGraphics *
 gvir_designer_domain_create_graphics_desktop(GVirDesignerDomain *design,
                                              GError **error)
@@ -562,9 +863,7 @@ gvir_designer_domain_add_graphics(GVirDesignerDomain *design,
 
         spice = gvir_config_domain_graphics_spice_new();
         gvir_config_domain_graphics_spice_set_autoport(spice, TRUE);
-        /* FIXME: Should only be done for local domains */
-        gvir_config_domain_graphics_spice_set_image_compression(spice,
-                                                                GVIR_CONFIG_DOMAIN_GRAPHICS_SPICE_IMAGE_COMPRESSION_OFF);
+        gvir_designer_domain_setup_spice_compression(design, spice);
         graphics = GVIR_CONFIG_DOMAIN_GRAPHICS(spice);
         if (!gvir_designer_domain_has_spice_channel(design))
             gvir_designer_domain_add_spice_channel(design, error);
@@ -603,11 +902,16 @@ static gboolean
 gvir_designer_domain_supports_usb(GVirDesignerDomain *design)
 {
     GList *devices;
+
+    if (design->priv->has_usb_controller)
+        return TRUE;
+
     devices = gvir_designer_domain_get_device_by_type(design,
                                                       GVIR_CONFIG_TYPE_DOMAIN_CONTROLLER_USB);
     g_list_free_full(devices, g_object_unref);
+    design->priv->has_usb_controller = (devices != NULL);
 
-    return (devices != NULL);
+    return design->priv->has_usb_controller;
 }
 
 
@@ -633,6 +937,97 @@ gvir_designer_domain_create_usb_controller(GVirDesignerDomain *design,
 }
 
 
+/**
+ * gvir_designer_domain_set_usb_mode:
+ * @design: (transfer none): the domain designer instance
+ * @mode: the USB controllers to add
+ *
+ * Selects the USB controllers gvir_designer_domain_add_usb_redir() adds
+ * when @design has none yet. The default,
+ * GVIR_DESIGNER_DOMAIN_USB_MODE_AUTO, picks a single qemu-xhci controller
+ * when both the OS and the hypervisor support it, and an EHCI controller
+ * with its UHCI companions otherwise.
+ */
+void
+gvir_designer_domain_set_usb_mode(GVirDesignerDomain *design,
+                                  GVirDesignerDomainUsbMode mode)
+{
+    g_return_if_fail(GVIR_DESIGNER_IS_DOMAIN(design));
+
+    design->priv->usb_mode = mode;
+}
+
+
+/* Whether the hypervisor is QEMU/KVM and both the OS and the platform
+ * support the device @id */
+static gboolean
+gvir_designer_domain_supports_qemu_device(GVirDesignerDomain *design,
+                                          const char *id)
+{
+    GVirConfigDomainVirtType virt_type;
+    OsinfoDeviceList *devices;
+    OsinfoFilter *filter;
+    gboolean found = FALSE;
+
+    virt_type = gvir_config_domain_get_virt_type(design->priv->config);
+    if (virt_type != GVIR_CONFIG_DOMAIN_VIRT_QEMU &&
+        virt_type != GVIR_CONFIG_DOMAIN_VIRT_KVM)
+        return FALSE;
+
+    filter = osinfo_filter_new();
+    osinfo_filter_add_constraint(filter, OSINFO_ENTITY_PROP_ID, id);
+    devices = gvir_designer_domain_get_supported_devices(design, filter);
+    if (devices != NULL) {
+        found = (osinfo_list_get_length(OSINFO_LIST(devices)) > 0);
+        g_object_unref(G_OBJECT(devices));
+    }
+    g_object_unref(G_OBJECT(filter));
+
+    return found;
+}
+
+
+/* One port per redirection channel, never below the qemu-xhci default */
+static void
+gvir_designer_domain_update_xhci_ports(GVirDesignerDomain *design)
+{
+    xmlNodePtr node;
+    guint ports;
+
+    if (design->priv->xhci_controller == NULL)
+        return;
+
+    ports = CLAMP(design->priv->n_usb_redirs,
+                  GVIR_DESIGNER_XHCI_MIN_PORTS,
+                  GVIR_DESIGNER_XHCI_MAX_PORTS);
+    node = gvir_designer_xml_get_node(GVIR_CONFIG_OBJECT(design->priv->xhci_controller));
+    gvir_designer_xml_set_attribute_uint(node, "ports", ports);
+}
+
+
+static void
+gvir_designer_domain_add_xhci_controller(GVirDesignerDomain *design)
+{
+    GVirConfigDomainControllerUsb *controller;
+    xmlNodePtr node;
+
+    g_debug("Adding qemu-xhci USB controller");
+
+    /* libvirt-gconfig only knows about the NEC xHCI model */
+    controller = gvir_designer_domain_create_usb_controller(design,
+                                                            GVIR_CONFIG_DOMAIN_CONTROLLER_USB_MODEL_NEC_XHCI,
+                                                            0,
+                                                            NULL,
+                                                            0);
+    node = gvir_designer_xml_get_node(GVIR_CONFIG_OBJECT(controller));
+    gvir_designer_xml_set_attribute(node, "model", "qemu-xhci");
+
+    design->priv->xhci_controller = controller;
+    design->priv->has_usb_controller = TRUE;
+    gvir_designer_domain_update_xhci_ports(design);
+}
+
+
 static void
 gvir_designer_domain_add_usb_controllers(GVirDesignerDomain *design)
 {
@@ -665,6 +1060,7 @@ gvir_designer_domain_add_usb_controllers(GVirDesignerDomain *design)
                                                             4);
     g_object_unref(G_OBJECT(controller));
     g_object_unref(G_OBJECT(master));
+    design->priv->has_usb_controller = TRUE;
 }
 
 
@@ -677,7 +1073,7 @@ gvir_designer_domain_add_usb_controllers(GVirDesignerDomain *design)
  * an USB device from the SPICE client to the guest. One USB device
  * can be redirected per redirection channel, this function can
  * be called multiple times if you need to redirect multiple devices
- * simultaneously. An USB2 EHCI controller and USB1 UHCI controllers
+ * simultaneously. USB controllers, see gvir_designer_domain_set_usb_mode(),
  * will be automatically added to @design if @design does not have
  * USB controllers yet.
  *
@@ -696,6 +1092,13 @@ gvir_designer_domain_add_usb_redir(GVirDesignerDomain *design,
     g_return_val_if_fail(GVIR_DESIGNER_IS_DOMAIN(design), NULL);
     g_return_val_if_fail(!error_is_set(error), NULL);
 
+    if (design->priv->xhci_controller &&
+        design->priv->n_usb_redirs >= GVIR_DESIGNER_XHCI_MAX_PORTS) {
+        g_set_error(error, GVIR_DESIGNER_DOMAIN_ERROR, 0,
+                    "USB controller has no port left for redirection");
+        return NULL;
+    }
+
     redirdev = gvir_config_domain_redirdev_new();
     gvir_config_domain_redirdev_set_bus(redirdev,
                                         GVIR_CONFIG_DOMAIN_REDIRDEV_BUS_USB);
@@ -707,10 +1110,28 @@ gvir_designer_domain_add_usb_redir(GVirDesignerDomain *design,
     gvir_config_domain_add_device(design->priv->config,
                                   GVIR_CONFIG_DOMAIN_DEVICE(redirdev));
 
+    design->priv->n_usb_redirs++;
+
     if (!gvir_designer_domain_supports_usb(design)) {
-        gvir_designer_domain_add_usb_controllers(design);
+        switch (design->priv->usb_mode) {
+        case GVIR_DESIGNER_DOMAIN_USB_MODE_XHCI:
+            gvir_designer_domain_add_xhci_controller(design);
+            break;
+        case GVIR_DESIGNER_DOMAIN_USB_MODE_COMPANION:
+            gvir_designer_domain_add_usb_controllers(design);
+            break;
+        case GVIR_DESIGNER_DOMAIN_USB_MODE_AUTO:
+        default:
+            if (gvir_designer_domain_supports_qemu_device(design,
+                                                          GVIR_DESIGNER_QEMU_XHCI_DEVICE_ID))
+                gvir_designer_domain_add_xhci_controller(design);
+            else
+                gvir_designer_domain_add_usb_controllers(design);
+            break;
+        }
     } else {
         g_debug("USB controllers are already present");
+        gvir_designer_domain_update_xhci_ports(design);
     }
 
     return redirdev;
@@ -799,11 +1220,64 @@ gvir_designer_domain_add_console(GVirDesignerDomain *design)
 }
 
 
+/**
+ * gvir_designer_domain_set_headless:
+ * @design: (transfer none): the domain designer instance
+ * @headless: whether nobody will interact with the guest display
+ *
+ * Headless designs get no input device from
+ * gvir_designer_domain_setup_machine(), which must thus be called
+ * afterwards for this to have any effect.
+ */
+void
+gvir_designer_domain_set_headless(GVirDesignerDomain *design,
+                                  gboolean headless)
+{
+    g_return_if_fail(GVIR_DESIGNER_IS_DOMAIN(design));
+
+    design->priv->headless = headless;
+}
+
+
+static void
+gvir_designer_domain_add_virtio_input(GVirDesignerDomain *design,
+                                      const char *type)
+{
+    GVirConfigDomainInput *input;
+    xmlNodePtr node;
+
+    input = gvir_config_domain_input_new();
+    gvir_config_domain_input_set_device_type(input,
+                                             GVIR_CONFIG_DOMAIN_INPUT_DEVICE_TABLET);
+
+    /* libvirt-gconfig knows neither keyboards nor the virtio bus */
+    node = gvir_designer_xml_get_node(GVIR_CONFIG_OBJECT(input));
+    gvir_designer_xml_set_attribute(node, "type", type);
+    gvir_designer_xml_set_attribute(node, "bus", "virtio");
+
+    gvir_config_domain_add_device(design->priv->config,
+                                  GVIR_CONFIG_DOMAIN_DEVICE(input));
+    g_object_unref(G_OBJECT(input));
+}
+
+
 static void
 gvir_designer_domain_add_input(GVirDesignerDomain *design)
 {
     GVirConfigDomainInput *input;
 
+    if (design->priv->headless)
+        return;
+
+    /* virtio-input only interrupts the guest on events, when the USB
+     * tablet gets polled all the time */
+    if (gvir_designer_domain_supports_qemu_device(design,
+                                                  GVIR_DESIGNER_VIRTIO_INPUT_DEVICE_ID)) {
+        gvir_designer_domain_add_virtio_input(design, "tablet");
+        gvir_designer_domain_add_virtio_input(design, "keyboard");
+        return;
+    }
+
     input = gvir_config_domain_input_new();
     gvir_config_domain_input_set_device_type(input,
                                              GVIR_CONFIG_DOMAIN_INPUT_DEVICE_TABLET);
@@ -814,6 +1288,16 @@ gvir_designer_domain_add_input(GVirDesignerDomain *design)
 }
 
 
+static void
+gvir_designer_disk_targets_free(gpointer data)
+{
+    GVirDesignerDiskTargets *targets = data;
+
+    g_array_unref(targets->used);
+    g_free(targets);
+}
+
+
 static void
 gvir_designer_domain_init(GVirDesignerDomain *design)
 {
@@ -821,8 +1305,105 @@ gvir_designer_domain_init(GVirDesignerDomain *design)
     g_debug("Init GVirDesignerDomain=%p", design);
 
     priv = design->priv = GVIR_DESIGNER_DOMAIN_GET_PRIVATE(design);
-    priv->config = gvir_config_domain_new();
     priv->drivers = osinfo_device_driverlist_new();
+    priv->disk_targets = g_hash_table_new_full(g_str_hash, g_str_equal, NULL,
+                                               gvir_designer_disk_targets_free);
+}
+
+
+/* Picks up what the designer needs to know about a config it did not
+ * create: disk targets in use, USB controllers and redirections, the
+ * SPICE channel, the virtio-scsi controller and the IOThreads along with
+ * how many devices already use one. The virt type is always read back
+ * from the config. */
+static void
+gvir_designer_domain_constructed(GObject *object)
+{
+    GVirDesignerDomain *design = GVIR_DESIGNER_DOMAIN(object);
+    GVirDesignerDomainPrivate *priv = design->priv;
+    GList *devices;
+    GList *it;
+    xmlNodePtr domain;
+    xmlNodePtr node;
+    guint64 iothreads;
+    guint iothread_users = 0;
+
+    if (G_OBJECT_CLASS(gvir_designer_domain_parent_class)->constructed)
+        G_OBJECT_CLASS(gvir_designer_domain_parent_class)->constructed(object);
+
+    if (priv->config == NULL) {
+        priv->config = gvir_config_domain_new();
+        return;
+    }
+
+    devices = gvir_config_domain_get_devices(priv->config);
+    for (it = devices; it != NULL; it = it->next) {
+        if (GVIR_CONFIG_IS_DOMAIN_DISK(it->data)) {
+            GVirConfigDomainDisk *disk = GVIR_CONFIG_DOMAIN_DISK(it->data);
+            const char *target = gvir_config_domain_disk_get_target_dev(disk);
+            GError *error = NULL;
+
+            if (gvir_config_domain_disk_get_guest_device_type(disk) ==
+                GVIR_CONFIG_DOMAIN_DISK_GUEST_DEVICE_DISK &&
+                gvir_config_domain_disk_get_target_bus(disk) ==
+                GVIR_CONFIG_DOMAIN_DISK_BUS_VIRTIO)
+                priv->n_virtio_disks++;
+            if (target == NULL)
+                continue;
+            if (!gvir_designer_domain_reserve_disk_target(design, target, &error)) {
+                g_debug("Ignoring disk target: %s", error->message);
+                g_clear_error(&error);
+            }
+        } else if (GVIR_CONFIG_IS_DOMAIN_CONTROLLER_USB(it->data)) {
+            priv->has_usb_controller = TRUE;
+            /* its ports follow the redirections from now on */
+            if (priv->xhci_controller == NULL &&
+                gvir_designer_xml_has_attribute_value(gvir_designer_xml_get_node(GVIR_CONFIG_OBJECT(it->data)),
+                                                      "model", "qemu-xhci"))
+                priv->xhci_controller = g_object_ref(it->data);
+        } else if (GVIR_CONFIG_IS_DOMAIN_REDIRDEV(it->data)) {
+            priv->n_usb_redirs++;
+        } else if (GVIR_CONFIG_IS_DOMAIN_CHANNEL(it->data)) {
+            if (gvir_designer_domain_channel_is_spice(GVIR_CONFIG_DOMAIN_CHANNEL(it->data)))
+                priv->has_spice_channel = TRUE;
+        }
+    }
+    g_list_free_full(devices, g_object_unref);
+
+    /* libvirt-gconfig knows neither SCSI controllers nor IOThreads */
+    domain = gvir_designer_xml_get_node(GVIR_CONFIG_OBJECT(priv->config));
+    node = gvir_designer_xml_get_child(domain, "devices");
+    for (node = node ? node->children : NULL; node != NULL; node = node->next) {
+        xmlNodePtr driver;
+        guint iothread;
+
+        if (node->type != XML_ELEMENT_NODE)
+            continue;
+        if (xmlStrEqual(node->name, (const xmlChar *)"controller")) {
+            if (!priv->has_virtio_scsi_controller &&
+                gvir_designer_xml_has_attribute_value(node, "type", "scsi") &&
+                gvir_designer_xml_has_attribute_value(node, "model", "virtio-scsi")) {
+                if (!gvir_designer_xml_get_attribute_uint(node, "index",
+                                                          &priv->virtio_scsi_index))
+                    priv->virtio_scsi_index = 0;
+                priv->has_virtio_scsi_controller = TRUE;
+            }
+        } else if (!xmlStrEqual(node->name, (const xmlChar *)"disk")) {
+            continue;
+        }
+
+        driver = gvir_designer_xml_get_child(node, "driver");
+        if (driver && gvir_designer_xml_get_attribute_uint(driver, "iothread", &iothread))
+            iothread_users++;
+    }
+
+    node = gvir_designer_xml_get_child(domain, "iothreads");
+    if (node && gvir_designer_xml_get_content_uint64(node, &iothreads) &&
+        iothreads > 0 && iothreads <= G_MAXUINT) {
+        priv->n_iothreads = iothreads;
+        /* carry on with the round-robin where it stopped */
+        priv->next_iothread = iothread_users % priv->n_iothreads;
+    }
 }
 
 
@@ -841,6 +1422,41 @@ gvir_designer_domain_new(OsinfoDb *db,
 }
 
 
+/**
+ * gvir_designer_domain_new_from_config:
+ * @db: (transfer none): the libosinfo database
+ * @os: (transfer none): the operating system running in the domain
+ * @platform: (transfer none): the platform the domain runs on
+ * @caps: (transfer none): the host capabilities
+ * @config: (transfer none): an existing domain configuration
+ *
+ * Creates a designer which extends @config instead of starting from an
+ * empty domain. Disk targets, USB controllers and the SPICE channel
+ * already present in @config are taken into account by the
+ * gvir_designer_domain_add_*() functions. @config is modified in place,
+ * gvir_designer_domain_get_config() returns it.
+ *
+ * Returns: (transfer full): a new designer
+ */
+GVirDesignerDomain *
+gvir_designer_domain_new_from_config(OsinfoDb *db,
+                                     OsinfoOs *os,
+                                     OsinfoPlatform *platform,
+                                     GVirConfigCapabilities *caps,
+                                     GVirConfigDomain *config)
+{
+    g_return_val_if_fail(GVIR_CONFIG_IS_DOMAIN(config), NULL);
+
+    return GVIR_DESIGNER_DOMAIN(g_object_new(GVIR_DESIGNER_TYPE_DOMAIN,
+                                             "osinfo-db", db,
+                                             "os", os,
+                                             "platform", platform,
+                                             "capabilities", caps,
+                                             "config", config,
+                                             NULL));
+}
+
+
 /**
  * gvir_designer_domain_get_os:
  * @design: (transfer none): the domain designer instance
@@ -954,8 +1570,10 @@ gvir_designer_domain_get_arch_native(GVirDesignerDomain *design)
         uname(&ut);
         arch_native = gvir_designer_domain_get_arch_normalized(ut.machine);
     }
-    g_object_unref(G_OBJECT(cpu));
-    g_object_unref(G_OBJECT(host));
+    if (cpu)
+        g_object_unref(G_OBJECT(cpu));
+    if (host)
+        g_object_unref(G_OBJECT(host));
 
     return arch_native;
 }
@@ -1175,12 +1793,15 @@ gvir_designer_domain_setup_guest(GVirDesignerDomain *design,
     gvir_config_domain_os_set_arch(
         os,
         gvir_config_capabilities_guest_arch_get_name(arch));
+    if (priv->machine_type)
+        gvir_config_domain_os_set_machine(os, priv->machine_type);
     gvir_config_domain_set_virt_type(
         priv->config,
         gvir_config_capabilities_guest_domain_get_virt_type(domain));
     gvir_config_domain_set_os(priv->config, os);
 
     gvir_designer_domain_add_clock(design);
+    gvir_designer_domain_add_hyperv(design);
     gvir_designer_domain_add_power_management(design);
     gvir_designer_domain_set_lifecycle(design);
     gvir_designer_domain_add_console(design);
@@ -1335,19 +1956,24 @@ gvir_designer_domain_get_preferred_device(GVirDesignerDomain *design,
                         "Unable to find any deployment in libosinfo database");
             goto cleanup;
         }
-        priv->deployment = deployment = osinfo_db_find_deployment(priv->osinfo_db,
-                                                                  priv->os,
-                                                                  priv->platform);
+        deployment = osinfo_db_find_deployment(priv->osinfo_db,
+                                               priv->os,
+                                               priv->platform);
         if (!deployment) {
             g_set_error(error, GVIR_DESIGNER_DOMAIN_ERROR, 0,
                         "Unable to find any deployment in libosinfo database");
             goto cleanup;
         }
+        /* the deployment belongs to the database */
+        priv->deployment = g_object_ref(deployment);
     }
 
     osinfo_filter_add_constraint(filter, "class", class);
     filter_link = osinfo_devicelinkfilter_new(filter);
     dev_link = osinfo_deployment_get_preferred_device_link(deployment, OSINFO_FILTER(filter_link));
+    /* the link belongs to the deployment, callers get their own reference */
+    if (dev_link != NULL)
+        g_object_ref(dev_link);
 
 cleanup:
     if (filter_link)
@@ -1372,6 +1998,8 @@ gvir_designer_domain_get_preferred_soundcard(GVirDesignerDomain *design,
         goto cleanup;
 
     device = osinfo_devicelink_get_target(dev_link);
+    if (device != NULL)
+        g_object_ref(device);
 
 cleanup:
     if (dev_link != NULL)
@@ -1482,6 +2110,7 @@ gvir_designer_domain_add_sound(GVirDesignerDomain *design, GError **error)
     sound = gvir_config_domain_sound_new();
     model = gvir_designer_sound_model_from_soundcard(soundcard);
     gvir_config_domain_sound_set_model(sound, model);
+    g_object_unref(soundcard);
 
     gvir_config_domain_add_device(design->priv->config,
                                   GVIR_CONFIG_DOMAIN_DEVICE(sound));
@@ -1490,35 +2119,218 @@ gvir_designer_domain_add_sound(GVirDesignerDomain *design, GError **error)
 }
 
 
-static gchar *
-gvir_designer_domain_next_disk_target(GVirDesignerDomain *design,
-                                      GVirConfigDomainDiskBus bus)
-{
-    gchar *ret = NULL;
-    GVirDesignerDomainPrivate *priv = design->priv;
+/* Target prefixes, in the order libvirt knows them. SATA, SCSI and USB
+ * disks all share the "sd" namespace. */
+static const char * const gvir_designer_disk_target_prefixes[] = {
+    "fd", "hd", "vd", "sd", "xvd", "ubd",
+};
 
+static const char *
+gvir_designer_disk_target_prefix(GVirConfigDomainDiskBus bus)
+{
     switch (bus) {
+    case GVIR_CONFIG_DOMAIN_DISK_BUS_FDC:
+        return "fd";
     case GVIR_CONFIG_DOMAIN_DISK_BUS_IDE:
-        ret = g_strdup_printf("hd%c", 'a' + priv->ide++);
-        break;
+        return "hd";
     case GVIR_CONFIG_DOMAIN_DISK_BUS_VIRTIO:
-        ret = g_strdup_printf("vd%c", 'a' + priv->virtio++);
-        break;
+        return "vd";
     case GVIR_CONFIG_DOMAIN_DISK_BUS_SATA:
-        ret = g_strdup_printf("sd%c", 'a' + priv->sata++);
-        break;
-    case GVIR_CONFIG_DOMAIN_DISK_BUS_FDC:
     case GVIR_CONFIG_DOMAIN_DISK_BUS_SCSI:
-    case GVIR_CONFIG_DOMAIN_DISK_BUS_XEN:
     case GVIR_CONFIG_DOMAIN_DISK_BUS_USB:
+        return "sd";
+    case GVIR_CONFIG_DOMAIN_DISK_BUS_XEN:
+        return "xvd";
     case GVIR_CONFIG_DOMAIN_DISK_BUS_UML:
+        return "ubd";
     default:
-        /* not supported yet */
-        /* XXX should we fallback to ide/virtio? */
-        break;
+        return NULL;
     }
+}
 
-    return ret;
+
+/* Formats @index the way libvirt does: a, b, ..., z, aa, ab, ... */
+static gchar *
+gvir_designer_disk_target_format(const char *prefix, guint index)
+{
+    char letters[8];
+    int pos = sizeof(letters) - 1;
+    gint64 i = index;
+
+    letters[pos] = '\0';
+    do {
+        letters[--pos] = 'a' + (i % 26);
+        i = i / 26 - 1;
+    } while (i >= 0);
+
+    return g_strconcat(prefix, letters + pos, NULL);
+}
+
+
+/* Reverse of gvir_designer_disk_target_format(), @prefix is set to one
+ * of gvir_designer_disk_target_prefixes */
+static gboolean
+gvir_designer_disk_target_parse(const char *target,
+                                const char **prefix,
+                                guint *index)
+{
+    const char *ptr = NULL;
+    guint64 val = 0;
+    unsigned int i;
+
+    for (i = 0; i < G_N_ELEMENTS(gvir_designer_disk_target_prefixes); i++) {
+        if (g_str_has_prefix(target, gvir_designer_disk_target_prefixes[i])) {
+            *prefix = gvir_designer_disk_target_prefixes[i];
+            ptr = target + strlen(*prefix);
+            break;
+        }
+    }
+    if (ptr == NULL || *ptr == '\0')
+        return FALSE;
+
+    for (i = 0; *ptr; i++, ptr++) {
+        if (!g_ascii_islower(*ptr))
+            return FALSE;
+        val = (val + (i ? 1 : 0)) * 26 + (*ptr - 'a');
+        if (val >= GVIR_DESIGNER_DISK_TARGET_MAX)
+            return FALSE;
+    }
+    *index = val;
+
+    return TRUE;
+}
+
+
+static GVirDesignerDiskTargets *
+gvir_designer_domain_get_disk_targets(GVirDesignerDomain *design,
+                                      const char *prefix)
+{
+    GVirDesignerDiskTargets *targets;
+
+    targets = g_hash_table_lookup(design->priv->disk_targets, prefix);
+    if (targets == NULL) {
+        targets = g_new0(GVirDesignerDiskTargets, 1);
+        targets->used = g_array_new(FALSE, TRUE, sizeof(guint32));
+        g_hash_table_insert(design->priv->disk_targets,
+                            (gpointer)prefix, targets);
+    }
+
+    return targets;
+}
+
+
+static gboolean
+gvir_designer_disk_targets_is_used(GVirDesignerDiskTargets *targets,
+                                   guint index)
+{
+    if (index / 32 >= targets->used->len)
+        return FALSE;
+
+    return (g_array_index(targets->used, guint32, index / 32) &
+            (1U << (index % 32))) != 0;
+}
+
+
+static void
+gvir_designer_disk_targets_set_used(GVirDesignerDiskTargets *targets,
+                                    guint index)
+{
+    if (index / 32 >= targets->used->len)
+        g_array_set_size(targets->used, index / 32 + 1);
+
+    g_array_index(targets->used, guint32, index / 32) |= 1U << (index % 32);
+}
+
+
+/* Targets are never released, so the search can start where the
+ * previous one stopped and skip whole words of used indexes */
+static gboolean
+gvir_designer_disk_targets_take_free(GVirDesignerDiskTargets *targets,
+                                     guint *free_index)
+{
+    guint word = targets->first_free / 32;
+    guint index;
+
+    while (word < targets->used->len &&
+           g_array_index(targets->used, guint32, word) == G_MAXUINT32)
+        word++;
+
+    index = MAX(targets->first_free, word * 32);
+    while (gvir_designer_disk_targets_is_used(targets, index))
+        index++;
+    if (index >= GVIR_DESIGNER_DISK_TARGET_MAX)
+        return FALSE;
+
+    gvir_designer_disk_targets_set_used(targets, index);
+    targets->first_free = index + 1;
+    *free_index = index;
+
+    return TRUE;
+}
+
+
+static gchar *
+gvir_designer_domain_next_disk_target(GVirDesignerDomain *design,
+                                      GVirConfigDomainDiskBus bus)
+{
+    GVirDesignerDiskTargets *targets;
+    const char *prefix;
+    guint index;
+
+    prefix = gvir_designer_disk_target_prefix(bus);
+    if (prefix == NULL)
+        return NULL;
+
+    targets = gvir_designer_domain_get_disk_targets(design, prefix);
+    if (!gvir_designer_disk_targets_take_free(targets, &index))
+        return NULL;
+
+    return gvir_designer_disk_target_format(prefix, index);
+}
+
+
+/**
+ * gvir_designer_domain_reserve_disk_target:
+ * @design: (transfer none): the domain designer instance
+ * @target: (transfer none): disk target name, eg "vdb"
+ * @error: return location for a #GError, or NULL
+ *
+ * Marks @target as used so that disks added afterwards never get it.
+ * This is needed when a disk is added to the domain config directly, or
+ * when the target of a disk added by the designer is changed.
+ *
+ * Returns: TRUE when successful, FALSE if @target is not a valid disk
+ * target name, has more than 3 letters after its prefix, or is already
+ * in use.
+ */
+gboolean
+gvir_designer_domain_reserve_disk_target(GVirDesignerDomain *design,
+                                         const char *target,
+                                         GError **error)
+{
+    GVirDesignerDiskTargets *targets;
+    const char *prefix;
+    guint index;
+
+    g_return_val_if_fail(GVIR_DESIGNER_IS_DOMAIN(design), FALSE);
+    g_return_val_if_fail(target != NULL, FALSE);
+    g_return_val_if_fail(!error_is_set(error), FALSE);
+
+    if (!gvir_designer_disk_target_parse(target, &prefix, &index)) {
+        g_set_error(error, GVIR_DESIGNER_DOMAIN_ERROR, 0,
+                    "Invalid disk target name: %s", target);
+        return FALSE;
+    }
+
+    targets = gvir_designer_domain_get_disk_targets(design, prefix);
+    if (gvir_designer_disk_targets_is_used(targets, index)) {
+        g_set_error(error, GVIR_DESIGNER_DOMAIN_ERROR, 0,
+                    "Disk target %s is already in use", target);
+        return FALSE;
+    }
+    gvir_designer_disk_targets_set_used(targets, index);
+
+    return TRUE;
 }
 
 static OsinfoDevice *
@@ -1533,6 +2345,8 @@ gvir_designer_domain_get_preferred_disk_controller(GVirDesignerDomain *design,
         goto cleanup;
 
     dev = osinfo_devicelink_get_target(dev_link);
+    if (dev != NULL)
+        g_object_ref(dev);
 
 cleanup:
     if (dev_link != NULL)
@@ -1575,6 +2389,8 @@ gvir_designer_domain_get_fallback_disk_controller(GVirDesignerDomain *design,
             osinfo_list_get_length(OSINFO_LIST(tmp_devices)) > 0) {
             g_object_unref(devices);
             devices = OSINFO_DEVICELIST(tmp_devices);
+        } else if (tmp_devices != NULL) {
+            g_object_unref(tmp_devices);
         }
         g_object_unref(G_OBJECT(filter));
     }
@@ -1589,6 +2405,46 @@ cleanup:
     return OSINFO_DEVICE(dev);
 }
 
+static gboolean
+gvir_designer_is_virtio_scsi_id(const char *id)
+{
+    unsigned int i;
+
+    for (i = 0; i < G_N_ELEMENTS(GVIR_DESIGNER_VIRTIO_SCSI_DEVICE_IDS); i++) {
+        if (g_str_equal(id, GVIR_DESIGNER_VIRTIO_SCSI_DEVICE_IDS[i]))
+            return TRUE;
+    }
+
+    return FALSE;
+}
+
+
+static gboolean
+gvir_designer_domain_supports_virtio_scsi(GVirDesignerDomain *design)
+{
+    gboolean found = FALSE;
+    unsigned int i;
+
+    for (i = 0; i < G_N_ELEMENTS(GVIR_DESIGNER_VIRTIO_SCSI_DEVICE_IDS) && !found; i++) {
+        OsinfoDeviceList *devices;
+        OsinfoFilter *filter;
+
+        filter = osinfo_filter_new();
+        osinfo_filter_add_constraint(filter,
+                                     OSINFO_ENTITY_PROP_ID,
+                                     GVIR_DESIGNER_VIRTIO_SCSI_DEVICE_IDS[i]);
+        devices = gvir_designer_domain_get_supported_devices(design, filter);
+        if (devices != NULL) {
+            found = (osinfo_list_get_length(OSINFO_LIST(devices)) > 0);
+            g_object_unref(G_OBJECT(devices));
+        }
+        g_object_unref(G_OBJECT(filter));
+    }
+
+    return found;
+}
+
+
 static GVirConfigDomainDiskBus
 gvir_designer_domain_get_bus_type_from_controller(GVirDesignerDomain *design,
                                                   OsinfoDevice *controller)
@@ -1596,718 +2452,2982 @@ gvir_designer_domain_get_bus_type_from_controller(GVirDesignerDomain *design,
     const char *id;
 
     id = osinfo_entity_get_id(OSINFO_ENTITY(controller));
-    if (g_str_equal(id, GVIR_DESIGNER_VIRTIO_BLOCK_DEVICE_ID) == 0)
+    if (g_str_equal(id, GVIR_DESIGNER_VIRTIO_BLOCK_DEVICE_ID))
         return GVIR_CONFIG_DOMAIN_DISK_BUS_VIRTIO;
+    if (gvir_designer_is_virtio_scsi_id(id))
+        return GVIR_CONFIG_DOMAIN_DISK_BUS_SCSI;
 
     return GVIR_CONFIG_DOMAIN_DISK_BUS_IDE;
 }
 
-static GVirConfigDomainDisk *
-gvir_designer_domain_add_disk_full(GVirDesignerDomain *design,
-                                   GVirConfigDomainDiskType type,
-                                   GVirConfigDomainDiskGuestDeviceType guest_type,
-                                   const char *path,
-                                   const char *format,
-                                   gchar *target,
-                                   GError **error)
+
+/* libvirt-gconfig has no SCSI controller object, look at the XML.
+ * Other SCSI models, such as lsilogic, are emulated HBAs which do not
+ * count: disks are only moved to virtio-scsi for its performance. */
+static gboolean
+gvir_designer_domain_has_virtio_scsi_controller(GVirDesignerDomain *design)
 {
-    GVirDesignerDomainPrivate *priv = design->priv;
-    GVirConfigDomainDisk *disk = NULL;
-    GVirConfigDomainDiskDriver *driver = NULL;
-    GVirConfigDomainDiskBus bus;
-    gchar *target_gen = NULL;
-    const char *driver_name;
-    int virt_type;
+    xmlNodePtr devices;
+    xmlNodePtr it;
 
-    OsinfoDevice *controller;
+    if (design->priv->has_virtio_scsi_controller)
+        return TRUE;
 
-    virt_type = gvir_config_domain_get_virt_type(priv->config);
-    switch (virt_type) {
-    case GVIR_CONFIG_DOMAIN_VIRT_QEMU:
-    case GVIR_CONFIG_DOMAIN_VIRT_KQEMU:
-    case GVIR_CONFIG_DOMAIN_VIRT_KVM:
-        driver_name = "qemu";
-        break;
-        /* add new virt type here */
-    default:
-        g_set_error(error, GVIR_DESIGNER_DOMAIN_ERROR, 0,
-                    "Unsupported virt type %d", virt_type);
-        goto error;
-        break;
+    devices = gvir_designer_xml_get_child(gvir_designer_xml_get_node(GVIR_CONFIG_OBJECT(design->priv->config)),
+                                          "devices");
+    if (devices == NULL)
+        return FALSE;
+
+    for (it = devices->children; it != NULL; it = it->next) {
+        if (it->type == XML_ELEMENT_NODE &&
+            xmlStrEqual(it->name, (const xmlChar *)"controller") &&
+            gvir_designer_xml_has_attribute_value(it, "type", "scsi") &&
+            gvir_designer_xml_has_attribute_value(it, "model", "virtio-scsi")) {
+            if (!gvir_designer_xml_get_attribute_uint(it, "index",
+                                                      &design->priv->virtio_scsi_index))
+                design->priv->virtio_scsi_index = 0;
+            design->priv->has_virtio_scsi_controller = TRUE;
+            break;
+        }
     }
 
-    driver = gvir_config_domain_disk_driver_new();
-    gvir_config_domain_disk_driver_set_name(driver, driver_name);
-    if (format) {
-        int fmt;
+    return design->priv->has_virtio_scsi_controller;
+}
 
-        fmt = gvir_designer_genum_get_value(GVIR_CONFIG_TYPE_DOMAIN_DISK_FORMAT,
-                                            format, -1);
 
-        if (fmt == -1) {
-            g_set_error(error, GVIR_DESIGNER_DOMAIN_ERROR, 0,
-                        "Unknown disk format: %s", format);
-            goto error;
+/* Next free index after all the SCSI controllers of the config */
+static guint
+gvir_designer_domain_next_scsi_controller_index(GVirDesignerDomain *design)
+{
+    xmlNodePtr devices;
+    xmlNodePtr it;
+    guint next = 0;
+
+    devices = gvir_designer_xml_get_child(gvir_designer_xml_get_node(GVIR_CONFIG_OBJECT(design->priv->config)),
+                                          "devices");
+    for (it = devices ? devices->children : NULL; it != NULL; it = it->next) {
+        guint index = 0;
+
+        if (it->type == XML_ELEMENT_NODE &&
+            xmlStrEqual(it->name, (const xmlChar *)"controller") &&
+            gvir_designer_xml_has_attribute_value(it, "type", "scsi")) {
+            gvir_designer_xml_get_attribute_uint(it, "index", &index);
+            next = MAX(next, index + 1);
         }
-
-        gvir_config_domain_disk_driver_set_format(driver, fmt);
     }
 
-    disk = gvir_config_domain_disk_new();
-    gvir_config_domain_disk_set_type(disk, type);
-    gvir_config_domain_disk_set_source(disk, path);
-    gvir_config_domain_disk_set_driver(disk, driver);
-    g_object_unref(driver);
-    driver = NULL;
+    return next;
+}
 
-    controller = gvir_designer_domain_get_preferred_disk_controller(design, NULL);
-    if (controller == NULL)
-        controller = gvir_designer_domain_get_fallback_disk_controller(design, NULL);
 
-    if (controller != NULL) {
-        bus = gvir_designer_domain_get_bus_type_from_controller(design, controller);
-    } else {
-        bus = GVIR_CONFIG_DOMAIN_DISK_BUS_IDE;
+/* Next free unit after the disks addressed to SCSI controller @index */
+static guint
+gvir_designer_domain_next_scsi_unit(GVirDesignerDomain *design,
+                                    guint index)
+{
+    xmlNodePtr devices;
+    xmlNodePtr it;
+    guint next = 0;
+
+    devices = gvir_designer_xml_get_child(gvir_designer_xml_get_node(GVIR_CONFIG_OBJECT(design->priv->config)),
+                                          "devices");
+    for (it = devices ? devices->children : NULL; it != NULL; it = it->next) {
+        xmlNodePtr address;
+        guint controller;
+        guint unit;
+
+        if (it->type != XML_ELEMENT_NODE ||
+            !xmlStrEqual(it->name, (const xmlChar *)"disk"))
+            continue;
+
+        address = gvir_designer_xml_get_child(it, "address");
+        if (address &&
+            gvir_designer_xml_has_attribute_value(address, "type", "drive") &&
+            gvir_designer_xml_get_attribute_uint(address, "controller", &controller) &&
+            controller == index &&
+            gvir_designer_xml_get_attribute_uint(address, "unit", &unit))
+            next = MAX(next, unit + 1);
     }
-    gvir_config_domain_disk_set_target_bus(disk, bus);
 
-    if (!target) {
-        target = target_gen = gvir_designer_domain_next_disk_target(design, bus);
-        if (!target_gen) {
-            g_set_error(error, GVIR_DESIGNER_DOMAIN_ERROR, 0,
-                        "unable to generate target name for bus '%d'", bus);
-            goto error;
-        }
-    }
-    gvir_config_domain_disk_set_target_dev(disk, target);
+    return next;
+}
 
-    g_free(target_gen);
 
-    gvir_config_domain_add_device(priv->config, GVIR_CONFIG_DOMAIN_DEVICE(disk));
+/* 1 based, as IOThread IDs are */
+static guint
+gvir_designer_domain_next_iothread(GVirDesignerDomain *design)
+{
+    GVirDesignerDomainPrivate *priv = design->priv;
+    guint iothread = priv->next_iothread % priv->n_iothreads + 1;
 
-    return disk;
+    priv->next_iothread = iothread % priv->n_iothreads;
 
-error:
-    g_free(target_gen);
-    if (driver != NULL)
-        g_object_unref(driver);
-    if (disk)
-        g_object_unref(disk);
-    return NULL;
+    return iothread;
+}
+
+
+/* Moves the disks and controllers running in an IOThread above
+ * @iothreads to one that is left, or back to the main loop when there
+ * are none, as libvirt refuses IDs that do not exist */
+static void
+gvir_designer_domain_remap_iothreads(GVirDesignerDomain *design,
+                                     guint iothreads)
+{
+    xmlNodePtr devices;
+    xmlNodePtr it;
+
+    devices = gvir_designer_xml_get_child(gvir_designer_xml_get_node(GVIR_CONFIG_OBJECT(design->priv->config)),
+                                          "devices");
+    if (devices == NULL)
+        return;
+
+    for (it = devices->children; it != NULL; it = it->next) {
+        xmlNodePtr driver;
+        guint iothread;
+
+        if (it->type != XML_ELEMENT_NODE ||
+            (!xmlStrEqual(it->name, (const xmlChar *)"disk") &&
+             !xmlStrEqual(it->name, (const xmlChar *)"controller")))
+            continue;
+
+        driver = gvir_designer_xml_get_child(it, "driver");
+        if (driver == NULL ||
+            !gvir_designer_xml_get_attribute_uint(driver, "iothread", &iothread) ||
+            iothread <= iothreads)
+            continue;
+
+        if (iothreads > 0) {
+            gvir_designer_xml_set_attribute_uint(driver, "iothread",
+                                                 (iothread - 1) % iothreads + 1);
+        } else {
+            gvir_designer_xml_set_attribute(driver, "iothread", NULL);
+            if (driver->properties == NULL && driver->children == NULL)
+                gvir_designer_xml_remove_node(driver);
+        }
+    }
 }
 
 
 /**
- * gvir_designer_domain_add_disk_file:
+ * gvir_designer_domain_set_iothreads:
  * @design: (transfer none): the domain designer instance
- * @filepath: (transfer none): the path to a file
- * @format: (transfer none): disk format
- * @error: return location for a #GError, or NULL
+ * @iothreads: number of IOThreads, or 0
  *
- * Add a new disk to the domain.
+ * Gives @design @iothreads IOThreads, event loops of their own which
+ * keep disk I/O off QEMU's main loop. virtio-blk disks and virtio-scsi
+ * controllers added from now on are spread over them round-robin,
+ * gvir_designer_domain_set_disk_iothread() moves a disk to a given one.
+ * Only QEMU and KVM support IOThreads. 0, the default, removes them.
  *
- * Returns: (transfer full): the pointer to new disk.
- * If something fails NULL is returned and @error is set.
+ * When the count shrinks, devices already running in an IOThread that
+ * goes away are spread over the remaining ones, or run in QEMU's main
+ * loop again when there are none left.
  */
-GVirConfigDomainDisk *
-gvir_designer_domain_add_disk_file(GVirDesignerDomain *design,
-                                   const char *filepath,
-                                   const char *format,
-                                   GError **error)
+void
+gvir_designer_domain_set_iothreads(GVirDesignerDomain *design,
+                                   guint iothreads)
 {
-    g_return_val_if_fail(GVIR_DESIGNER_IS_DOMAIN(design), NULL);
+    xmlNodePtr domain;
+    xmlNodePtr node;
+    gchar *content;
 
-    GVirConfigDomainDisk *ret = NULL;
+    g_return_if_fail(GVIR_DESIGNER_IS_DOMAIN(design));
 
-    ret = gvir_designer_domain_add_disk_full(design,
-                                             GVIR_CONFIG_DOMAIN_DISK_FILE,
-                                             GVIR_CONFIG_DOMAIN_DISK_GUEST_DEVICE_DISK,
-                                             filepath,
-                                             format,
-                                             NULL,
-                                             error);
-    return ret;
+    domain = gvir_designer_xml_get_node(GVIR_CONFIG_OBJECT(design->priv->config));
+    design->priv->n_iothreads = iothreads;
+    design->priv->next_iothread = 0;
+    gvir_designer_domain_remap_iothreads(design, iothreads);
+
+    if (iothreads == 0) {
+        node = gvir_designer_xml_get_child(domain, "iothreads");
+        if (node)
+            gvir_designer_xml_remove_node(node);
+        return;
+    }
+
+    node = gvir_designer_xml_ensure_child(domain, "iothreads");
+    content = g_strdup_printf("%u", iothreads);
+    gvir_designer_xml_set_content(node, content);
+    g_free(content);
 }
 
 
 /**
- * gvir_designer_domain_add_disk_device:
+ * gvir_designer_domain_set_disk_iothread:
  * @design: (transfer none): the domain designer instance
- * @devpath: (transfer none): path to the device
+ * @disk: (transfer none): a virtio-blk disk of @design
+ * @iothread: IOThread ID, from 1 to the number of IOThreads
  * @error: return location for a #GError, or NULL
  *
- * Add given device as a new disk to the domain designer instance.
+ * Runs the I/O of @disk in IOThread @iothread rather than in the one
+ * it was given when added. Disks on a virtio-scsi controller share
+ * its IOThread and cannot be moved one by one.
  *
- * Returns: (transfer full): the pointer to the new disk.
- * If something fails NULL is returned and @error is set.
+ * Returns: TRUE on success, FALSE with @error set otherwise.
  */
-GVirConfigDomainDisk *
-gvir_designer_domain_add_disk_device(GVirDesignerDomain *design,
-                                     const char *devpath,
-                                     GError **error)
+gboolean
+gvir_designer_domain_set_disk_iothread(GVirDesignerDomain *design,
+                                       GVirConfigDomainDisk *disk,
+                                       guint iothread,
+                                       GError **error)
 {
-    g_return_val_if_fail(GVIR_DESIGNER_IS_DOMAIN(design), NULL);
+    g_return_val_if_fail(GVIR_DESIGNER_IS_DOMAIN(design), FALSE);
+    g_return_val_if_fail(GVIR_CONFIG_IS_DOMAIN_DISK(disk), FALSE);
+    g_return_val_if_fail(!error_is_set(error), FALSE);
 
-    GVirConfigDomainDisk *ret = NULL;
+    if (iothread == 0 || iothread > design->priv->n_iothreads) {
+        g_set_error(error, GVIR_DESIGNER_DOMAIN_ERROR, 0,
+                    "IOThread %u does not exist, the domain has %u",
+                    iothread, design->priv->n_iothreads);
+        return FALSE;
+    }
 
-    ret = gvir_designer_domain_add_disk_full(design,
-                                             GVIR_CONFIG_DOMAIN_DISK_BLOCK,
-                                             GVIR_CONFIG_DOMAIN_DISK_GUEST_DEVICE_DISK,
-                                             devpath,
-                                             "raw",
-                                             NULL,
-                                             error);
-    return ret;
+    if (gvir_config_domain_disk_get_target_bus(disk) !=
+        GVIR_CONFIG_DOMAIN_DISK_BUS_VIRTIO) {
+        g_set_error(error, GVIR_DESIGNER_DOMAIN_ERROR, 0,
+                    "Disk '%s' is not a virtio-blk disk",
+                    gvir_config_domain_disk_get_target_dev(disk));
+        return FALSE;
+    }
+
+    gvir_designer_xml_set_attribute_uint(gvir_designer_xml_ensure_child(gvir_designer_xml_get_node(GVIR_CONFIG_OBJECT(disk)),
+                                                                        "driver"),
+                                         "iothread", iothread);
+
+    return TRUE;
+}
+
+
+static void
+gvir_designer_domain_add_scsi_controller(GVirDesignerDomain *design)
+{
+    xmlNodePtr devices;
+    xmlNodePtr controller;
+
+    g_debug("Adding virtio-scsi controller");
+
+    devices = gvir_designer_xml_ensure_child(gvir_designer_xml_get_node(GVIR_CONFIG_OBJECT(design->priv->config)),
+                                             "devices");
+    /* existing configs may already have an lsilogic or similar one */
+    design->priv->virtio_scsi_index = gvir_designer_domain_next_scsi_controller_index(design);
+    controller = gvir_designer_xml_add_child(devices, "controller");
+    gvir_designer_xml_set_attribute(controller, "type", "scsi");
+    gvir_designer_xml_set_attribute_uint(controller, "index",
+                                         design->priv->virtio_scsi_index);
+    gvir_designer_xml_set_attribute(controller, "model", "virtio-scsi");
+    /* its disks cannot have an IOThread of their own */
+    if (design->priv->n_iothreads > 0)
+        gvir_designer_xml_set_attribute_uint(gvir_designer_xml_add_child(controller, "driver"),
+                                             "iothread",
+                                             gvir_designer_domain_next_iothread(design));
+    design->priv->has_virtio_scsi_controller = TRUE;
+}
+
+
+/* libvirt puts SCSI disks without an address on controller 0 */
+static void
+gvir_designer_domain_set_scsi_address(GVirDesignerDomain *design,
+                                      GVirConfigDomainDisk *disk)
+{
+    guint index = design->priv->virtio_scsi_index;
+    xmlNodePtr address;
+
+    if (index == 0)
+        return;
+
+    address = gvir_designer_xml_add_child(gvir_designer_xml_get_node(GVIR_CONFIG_OBJECT(disk)),
+                                          "address");
+    gvir_designer_xml_set_attribute(address, "type", "drive");
+    gvir_designer_xml_set_attribute_uint(address, "controller", index);
+    gvir_designer_xml_set_attribute(address, "bus", "0");
+    gvir_designer_xml_set_attribute(address, "target", "0");
+    gvir_designer_xml_set_attribute_uint(address, "unit",
+                                         gvir_designer_domain_next_scsi_unit(design, index));
 }
 
+
 /**
- * gvir_designer_domain_add_cdrom_file:
+ * gvir_designer_domain_set_machine_type:
  * @design: (transfer none): the domain designer instance
- * @filepath: (transfer none): the path to a file
- * @format: (transfer none): file format
- * @error: return location for a #GError, or NULL
- *
- * Add a new disk to the domain.
+ * @machine: (allow-none): machine type, eg "q35", or NULL
  *
- * Returns: (transfer full): the pointer to new cdrom.
- * If something fails NULL is returned and @error is set.
+ * Sets the machine type of @design, which
+ * gvir_designer_domain_setup_machine() leaves to the hypervisor
+ * default otherwise. PCI Express machine types, such as q35, are needed
+ * by gvir_designer_domain_add_pcie_root_ports().
  */
-GVirConfigDomainDisk *
-gvir_designer_domain_add_cdrom_file(GVirDesignerDomain *design,
-                                    const char *filepath,
-                                    const char *format,
-                                    GError **error)
+void
+gvir_designer_domain_set_machine_type(GVirDesignerDomain *design,
+                                      const char *machine)
 {
-    g_return_val_if_fail(GVIR_DESIGNER_IS_DOMAIN(design), NULL);
+    GVirConfigDomainOs *os;
 
-    GVirConfigDomainDisk *ret = NULL;
+    g_return_if_fail(GVIR_DESIGNER_IS_DOMAIN(design));
 
-    ret = gvir_designer_domain_add_disk_full(design,
-                                             GVIR_CONFIG_DOMAIN_DISK_FILE,
-                                             GVIR_CONFIG_DOMAIN_DISK_GUEST_DEVICE_CDROM,
-                                             filepath,
-                                             format,
-                                             NULL,
-                                             error);
+    g_free(design->priv->machine_type);
+    design->priv->machine_type = g_strdup(machine);
+
+    os = gvir_config_domain_get_os(design->priv->config);
+    if (os) {
+        gvir_config_domain_os_set_machine(os, machine);
+        g_object_unref(os);
+    }
+}
+
+
+/* q35 and the ARM virt machine have a PCI Express root complex, i440fx
+ * and friends only have a conventional PCI bus */
+static gboolean
+gvir_designer_domain_is_pcie_machine(GVirDesignerDomain *design)
+{
+    GVirConfigDomainOs *os = gvir_config_domain_get_os(design->priv->config);
+    const gchar *machine;
+    const gchar *arch;
+    gboolean ret = FALSE;
+
+    if (os == NULL)
+        return FALSE;
+
+    machine = gvir_config_domain_os_get_machine(os);
+    arch = gvir_config_domain_os_get_arch(os);
+    if (machine != NULL) {
+        if (g_str_equal(machine, "q35") || g_str_has_prefix(machine, "pc-q35-"))
+            ret = TRUE;
+        else if (g_strcmp0(arch, "aarch64") == 0 && g_str_has_prefix(machine, "virt"))
+            ret = TRUE;
+    }
+
+    g_object_unref(os);
     return ret;
 }
 
 
+/* Whether libvirt puts @device, which has no address, on a root port.
+ * Integrated devices (SATA, the primary video) sit on the root complex
+ * itself, everything virtio and the xHCI controllers need a port. */
+static gboolean
+gvir_designer_device_needs_root_port(xmlNodePtr device,
+                                     gboolean *has_video)
+{
+    xmlNodePtr child;
+
+    if (gvir_designer_xml_get_child(device, "address"))
+        return FALSE;
+
+    if (xmlStrEqual(device->name, (const xmlChar *)"disk")) {
+        child = gvir_designer_xml_get_child(device, "target");
+        return child && gvir_designer_xml_has_attribute_value(child, "bus", "virtio");
+    } else if (xmlStrEqual(device->name, (const xmlChar *)"interface")) {
+        return TRUE;
+    } else if (xmlStrEqual(device->name, (const xmlChar *)"controller")) {
+        return gvir_designer_xml_has_attribute_value(device, "model", "virtio-scsi") ||
+               gvir_designer_xml_has_attribute_value(device, "model", "qemu-xhci") ||
+               gvir_designer_xml_has_attribute_value(device, "model", "nec-xhci") ||
+               gvir_designer_xml_has_attribute_value(device, "type", "virtio-serial");
+    } else if (xmlStrEqual(device->name, (const xmlChar *)"input")) {
+        return gvir_designer_xml_has_attribute_value(device, "bus", "virtio");
+    } else if (xmlStrEqual(device->name, (const xmlChar *)"memballoon") ||
+               xmlStrEqual(device->name, (const xmlChar *)"rng")) {
+        return gvir_designer_xml_has_attribute_value(device, "model", "virtio");
+    } else if (xmlStrEqual(device->name, (const xmlChar *)"video")) {
+        gboolean primary = !*has_video;
+
+        *has_video = TRUE;
+        child = gvir_designer_xml_get_child(device, "model");
+        return !primary ||
+               (child && gvir_designer_xml_has_attribute_value(child, "type", "virtio"));
+    }
+
+    return FALSE;
+}
+
+
 /**
- * gvir_designer_domain_add_cdrom_device:
+ * gvir_designer_domain_add_pcie_root_ports:
  * @design: (transfer none): the domain designer instance
- * @devpath: (transfer none): path to the device
+ * @count: number of free root ports wanted
  * @error: return location for a #GError, or NULL
  *
- * Add given device as a new cdrom to the domain designer instance.
+ * Adds pcie-root-port controllers to @design so that, once libvirt has
+ * placed the devices @design has at this point, @count ports are still
+ * free. As many PCI Express devices can then be hotplugged later on
+ * instead of redefining and restarting the domain. libvirt puts devices
+ * without an address on any free port, so devices added after this
+ * call use up the spare ports, and calling it again only adds the
+ * ports missing.
  *
- * Returns: (transfer full): the pointer to the new cdrom.
- * If something fails NULL is returned and @error is set.
+ * The machine type of @design has to be PCI Express based, that is q35
+ * or the aarch64 virt machine, see gvir_designer_domain_set_machine_type().
+ *
+ * Returns: TRUE on success, FALSE with @error set otherwise.
  */
-GVirConfigDomainDisk *
-gvir_designer_domain_add_cdrom_device(GVirDesignerDomain *design,
-                                      const char *devpath,
-                                      GError **error)
+gboolean
+gvir_designer_domain_add_pcie_root_ports(GVirDesignerDomain *design,
+                                         guint count,
+                                         GError **error)
 {
-    g_return_val_if_fail(GVIR_DESIGNER_IS_DOMAIN(design), NULL);
+    xmlNodePtr devices;
+    xmlNodePtr it;
+    gboolean has_video = FALSE;
+    gboolean has_memballoon = FALSE;
+    guint next_index = 1;
+    guint n_ports = 0;
+    guint n_needed = 0;
+    guint i;
 
-    GVirConfigDomainDisk *ret = NULL;
+    g_return_val_if_fail(GVIR_DESIGNER_IS_DOMAIN(design), FALSE);
+    g_return_val_if_fail(!error_is_set(error), FALSE);
 
-    ret = gvir_designer_domain_add_disk_full(design,
-                                             GVIR_CONFIG_DOMAIN_DISK_BLOCK,
-                                             GVIR_CONFIG_DOMAIN_DISK_GUEST_DEVICE_CDROM,
-                                             devpath,
-                                             "raw",
-                                             NULL,
-                                             error);
-    return ret;
+    if (!gvir_designer_domain_is_pcie_machine(design)) {
+        g_set_error(error, GVIR_DESIGNER_DOMAIN_ERROR, 0,
+                    "PCIe root ports need a q35 or aarch64 virt machine type");
+        return FALSE;
+    }
+
+    /* libvirt-gconfig has no PCI controller object, look at the XML.
+     * Index 0 is the pcie-root libvirt adds by itself. */
+    devices = gvir_designer_xml_ensure_child(gvir_designer_xml_get_node(GVIR_CONFIG_OBJECT(design->priv->config)),
+                                             "devices");
+    for (it = devices->children; it != NULL; it = it->next) {
+        guint indx;
+
+        if (it->type != XML_ELEMENT_NODE)
+            continue;
+
+        if (xmlStrEqual(it->name, (const xmlChar *)"controller") &&
+            gvir_designer_xml_has_attribute_value(it, "type", "pci")) {
+            if (gvir_designer_xml_get_attribute_uint(it, "index", &indx) &&
+                indx >= next_index)
+                next_index = indx + 1;
+            if (gvir_designer_xml_has_attribute_value(it, "model", "pcie-root-port"))
+                n_ports++;
+            continue;
+        }
+
+        if (xmlStrEqual(it->name, (const xmlChar *)"memballoon"))
+            has_memballoon = TRUE;
+        if (gvir_designer_device_needs_root_port(it, &has_video))
+            n_needed++;
+    }
+    /* libvirt adds a virtio balloon to domains which have none */
+    if (!has_memballoon)
+        n_needed++;
+
+    for (i = n_ports; i < n_needed + count; i++) {
+        xmlNodePtr controller = gvir_designer_xml_add_child(devices, "controller");
+
+        gvir_designer_xml_set_attribute(controller, "type", "pci");
+        gvir_designer_xml_set_attribute_uint(controller, "index", next_index++);
+        gvir_designer_xml_set_attribute(controller, "model", "pcie-root-port");
+    }
+
+    return TRUE;
 }
 
 
 /**
- * gvir_designer_domain_add_floppy_file:
+ * gvir_designer_domain_set_virtio_scsi_threshold:
  * @design: (transfer none): the domain designer instance
- * @filepath: (transfer none): the path to a file
- * @format: (transfer none): file format
- * @error: return location for a #GError, or NULL
- *
- * Add a new disk to the domain.
+ * @threshold: number of disks, or 0
  *
- * Returns: (transfer full): the pointer to new floppy.
- * If something fails NULL is returned and @error is set.
+ * Once the domain has @threshold disks on a virtio-blk bus, disks which
+ * would otherwise be put there are attached to a virtio-scsi controller
+ * instead, provided the OS and platform support it. CD-ROMs and floppies
+ * do not count towards @threshold. virtio-blk uses one PCI slot per disk
+ * while a single virtio-scsi controller serves them all. The controller
+ * is added when the first SCSI disk is added. The default, 0, never
+ * switches.
  */
-GVirConfigDomainDisk *
-gvir_designer_domain_add_floppy_file(GVirDesignerDomain *design,
-                                     const char *filepath,
-                                     const char *format,
-                                     GError **error)
+void
+gvir_designer_domain_set_virtio_scsi_threshold(GVirDesignerDomain *design,
+                                               guint threshold)
 {
-    g_return_val_if_fail(GVIR_DESIGNER_IS_DOMAIN(design), NULL);
+    g_return_if_fail(GVIR_DESIGNER_IS_DOMAIN(design));
 
-    GVirConfigDomainDisk *ret = NULL;
-
-    ret = gvir_designer_domain_add_disk_full(design,
-                                             GVIR_CONFIG_DOMAIN_DISK_FILE,
-                                             GVIR_CONFIG_DOMAIN_DISK_GUEST_DEVICE_FLOPPY,
-                                             filepath,
-                                             format,
-                                             NULL,
-                                             error);
-    return ret;
+    design->priv->virtio_scsi_threshold = threshold;
 }
 
-
 /**
- * gvir_designer_domain_add_floppy_device:
+ * gvir_designer_domain_set_disk_profile:
  * @design: (transfer none): the domain designer instance
- * @devpath: (transfer none): path to the device
- * @error: return location for a #GError, or NULL
+ * @profile: the workload of the disks
  *
- * Add given device as a new floppy to the domain designer instance.
+ * Sets the workload the disks added from now on are tuned for, which
+ * decides their cache mode, I/O mode and discard handling:
  *
- * Returns: (transfer full): the pointer to the new floppy.
- * If something fails NULL is returned and @error is set.
+ * GVIR_DESIGNER_DOMAIN_DISK_PROFILE_SAFE, the default, bypasses the host
+ * page cache (cache='none'), so that writes the guest has flushed are on
+ * the storage and memory is not cached twice. Block devices and raw
+ * files use native AIO, other formats use the thread pool, which does
+ * not block QEMU while image metadata grows. qcow2 images pass guest
+ * discards through so that they shrink back.
+ *
+ * GVIR_DESIGNER_DOMAIN_DISK_PROFILE_THROUGHPUT is for sequential and
+ * highly parallel I/O: it uses io_uring and passes discards through.
+ *
+ * GVIR_DESIGNER_DOMAIN_DISK_PROFILE_LATENCY is for small synchronous
+ * I/O: it uses native AIO wherever it does not block, io_uring
+ * elsewhere, and ignores discards, which can stall other requests.
+ *
+ * GVIR_DESIGNER_DOMAIN_DISK_PROFILE_SCRATCH is for data that can be
+ * lost: it goes through the host page cache and ignores guest flushes
+ * (cache='unsafe'), a host crash corrupts the disk.
+ *
+ * GVIR_DESIGNER_DOMAIN_DISK_PROFILE_NONE leaves the hypervisor defaults.
+ *
+ * CD-ROMs and floppies are not affected.
  */
-GVirConfigDomainDisk *
-gvir_designer_domain_add_floppy_device(GVirDesignerDomain *design,
-                                       const char *devpath,
-                                       GError **error)
+void
+gvir_designer_domain_set_disk_profile(GVirDesignerDomain *design,
+                                      GVirDesignerDomainDiskProfile profile)
 {
-    g_return_val_if_fail(GVIR_DESIGNER_IS_DOMAIN(design), NULL);
-
-    GVirConfigDomainDisk *ret = NULL;
+    g_return_if_fail(GVIR_DESIGNER_IS_DOMAIN(design));
 
-    ret = gvir_designer_domain_add_disk_full(design,
-                                             GVIR_CONFIG_DOMAIN_DISK_BLOCK,
-                                             GVIR_CONFIG_DOMAIN_DISK_GUEST_DEVICE_FLOPPY,
-                                             devpath,
-                                             "raw",
-                                             NULL,
-                                             error);
-    return ret;
+    design->priv->disk_profile = profile;
 }
 
 
-
-static const gchar *
-gvir_designer_domain_get_preferred_nic_model(GVirDesignerDomain *design,
-                                             GError **error)
+/**
+ * gvir_designer_domain_set_thin_provisioning:
+ * @design: (transfer none): the domain designer instance
+ * @mode: whether the disks added from now on give freed space back
+ *
+ * With GVIR_DESIGNER_DOMAIN_THIN_PROVISIONING_ENABLED guest discards
+ * (TRIM, UNMAP) are passed to the storage (discard='unmap') and blocks
+ * of zeroes the guest writes are turned into discards as well
+ * (detect_zeroes='unmap'), so that thin storage does not fill up with
+ * blocks the guest no longer uses. Detecting zeroes costs a scan of
+ * every write.
+ *
+ * GVIR_DESIGNER_DOMAIN_THIN_PROVISIONING_DISABLED ignores guest
+ * discards.
+ *
+ * GVIR_DESIGNER_DOMAIN_THIN_PROVISIONING_AUTO, the default, enables it
+ * on virtio-blk and virtio-scsi disks when the OS is known to send
+ * discards, unless the disk profile is GVIR_DESIGNER_DOMAIN_DISK_PROFILE_LATENCY
+ * or GVIR_DESIGNER_DOMAIN_DISK_PROFILE_NONE. Otherwise the disk profile
+ * decides.
+ *
+ * CD-ROMs and floppies are not affected.
+ */
+void
+gvir_designer_domain_set_thin_provisioning(GVirDesignerDomain *design,
+                                           GVirDesignerDomainThinProvisioning mode)
 {
-    const gchar *ret = NULL;
-    OsinfoDeviceLink *dev_link = NULL;
+    g_return_if_fail(GVIR_DESIGNER_IS_DOMAIN(design));
 
-    dev_link = gvir_designer_domain_get_preferred_device(design, "network", error);
-    if (!dev_link)
-        goto cleanup;
+    design->priv->thin_provisioning = mode;
+}
 
-    ret = osinfo_devicelink_get_driver(dev_link);
 
-cleanup:
-    if (dev_link)
-        g_object_unref(dev_link);
-    return ret;
+static void
+gvir_designer_disk_set_thin_provisioning(GVirConfigDomainDisk *disk,
+                                         gboolean enable)
+{
+    xmlNodePtr driver;
+
+    /* libvirt-gconfig has no detect_zeroes */
+    driver = gvir_designer_xml_ensure_child(gvir_designer_xml_get_node(GVIR_CONFIG_OBJECT(disk)),
+                                            "driver");
+    gvir_designer_xml_set_attribute(driver, "discard", enable ? "unmap" : "ignore");
+    /* only valid along with discard='unmap' */
+    gvir_designer_xml_set_attribute(driver, "detect_zeroes", enable ? "unmap" : NULL);
 }
 
 
-static GVirConfigDomainInterface *
-gvir_designer_domain_add_interface_full(GVirDesignerDomain *design,
-                                        GVirDesignerDomainNICType type,
-                                        const char *source,
-                                        GError **error)
+/* Linux and Windows from 7 on issue discards to virtio-blk and
+ * virtio-scsi disks, drivers without discard support just do not
+ * negotiate the feature */
+static gboolean
+gvir_designer_domain_supports_discard(GVirDesignerDomain *design,
+                                      GVirConfigDomainDiskBus bus)
 {
-    GVirConfigDomainInterface *ret = NULL;
-    const gchar *model = NULL;
+    if (bus != GVIR_CONFIG_DOMAIN_DISK_BUS_VIRTIO &&
+        bus != GVIR_CONFIG_DOMAIN_DISK_BUS_SCSI)
+        return FALSE;
 
-    model = gvir_designer_domain_get_preferred_nic_model(design, error);
+    if (gvir_designer_domain_is_windows(design))
+        return gvir_designer_domain_os_version_at_least(design, 6, 1);
 
-    switch (type) {
-    case GVIR_DESIGNER_DOMAIN_NIC_TYPE_BRIDGE:
-        ret = GVIR_CONFIG_DOMAIN_INTERFACE(gvir_config_domain_interface_bridge_new());
-        gvir_config_domain_interface_bridge_set_source(GVIR_CONFIG_DOMAIN_INTERFACE_BRIDGE(ret),
-                                                       source);
-        break;
-    case GVIR_DESIGNER_DOMAIN_NIC_TYPE_NETWORK:
-        ret = GVIR_CONFIG_DOMAIN_INTERFACE(gvir_config_domain_interface_network_new());
-        gvir_config_domain_interface_network_set_source(GVIR_CONFIG_DOMAIN_INTERFACE_NETWORK(ret),
-                                                        source);
+    return gvir_designer_domain_is_linux(design);
+}
+
+
+static void
+gvir_designer_domain_setup_disk_discard(GVirDesignerDomain *design,
+                                        GVirConfigDomainDisk *disk,
+                                        GVirConfigDomainDiskBus bus)
+{
+    switch (design->priv->thin_provisioning) {
+    case GVIR_DESIGNER_DOMAIN_THIN_PROVISIONING_ENABLED:
+        gvir_designer_disk_set_thin_provisioning(disk, TRUE);
         break;
-    case GVIR_DESIGNER_DOMAIN_NIC_TYPE_USER:
-        ret = GVIR_CONFIG_DOMAIN_INTERFACE(gvir_config_domain_interface_user_new());
+    case GVIR_DESIGNER_DOMAIN_THIN_PROVISIONING_DISABLED:
+        gvir_designer_disk_set_thin_provisioning(disk, FALSE);
         break;
+    case GVIR_DESIGNER_DOMAIN_THIN_PROVISIONING_AUTO:
     default:
-        g_set_error(error, GVIR_DESIGNER_DOMAIN_ERROR, 0,
-                    "Unsupported interface type '%d'", type);
-        goto cleanup;
+        if (design->priv->disk_profile != GVIR_DESIGNER_DOMAIN_DISK_PROFILE_LATENCY &&
+            design->priv->disk_profile != GVIR_DESIGNER_DOMAIN_DISK_PROFILE_NONE &&
+            gvir_designer_domain_supports_discard(design, bus))
+            gvir_designer_disk_set_thin_provisioning(disk, TRUE);
+        break;
     }
-
-    if (model)
-        gvir_config_domain_interface_set_model(ret, model);
-
-    gvir_config_domain_add_device(design->priv->config, GVIR_CONFIG_DOMAIN_DEVICE(ret));
-
-cleanup:
-    return ret;
 }
 
+
 /**
- * gvir_designer_domain_add_interface_bridge:
+ * gvir_designer_domain_set_disk_thin_provisioning:
  * @design: (transfer none): the domain designer instance
- * @bridge: (transfer none): bridge name
+ * @disk: (transfer none): a disk of @design
+ * @enable: whether to pass discards through
  * @error: return location for a #GError, or NULL
  *
- * Add new network interface card into @design. The interface is
- * of 'bridge' type and uses @bridge as the bridge device
+ * Overrides the thin provisioning @disk got when it was added, see
+ * gvir_designer_domain_set_thin_provisioning().
  *
- * Returns: (transfer full): the pointer to the new interface.
+ * Returns: TRUE on success, FALSE with @error set otherwise.
  */
-GVirConfigDomainInterface *
-gvir_designer_domain_add_interface_bridge(GVirDesignerDomain *design,
-                                          const char *bridge,
-                                          GError **error)
+gboolean
+gvir_designer_domain_set_disk_thin_provisioning(GVirDesignerDomain *design,
+                                                GVirConfigDomainDisk *disk,
+                                                gboolean enable,
+                                                GError **error)
 {
-    g_return_val_if_fail(GVIR_DESIGNER_IS_DOMAIN(design), NULL);
-    g_return_val_if_fail(bridge != NULL, NULL);
-    g_return_val_if_fail(!error_is_set(error), NULL);
+    g_return_val_if_fail(GVIR_DESIGNER_IS_DOMAIN(design), FALSE);
+    g_return_val_if_fail(GVIR_CONFIG_IS_DOMAIN_DISK(disk), FALSE);
+    g_return_val_if_fail(!error_is_set(error), FALSE);
+
+    if (gvir_config_domain_disk_get_guest_device_type(disk) !=
+        GVIR_CONFIG_DOMAIN_DISK_GUEST_DEVICE_DISK) {
+        g_set_error(error, GVIR_DESIGNER_DOMAIN_ERROR, 0,
+                    "Disk '%s' is not a hard disk",
+                    gvir_config_domain_disk_get_target_dev(disk));
+        return FALSE;
+    }
+
+    gvir_designer_disk_set_thin_provisioning(disk, enable);
+
+    return TRUE;
+}
+
+
+static void
+gvir_designer_domain_setup_disk_driver(GVirDesignerDomain *design,
+                                       GVirConfigDomainDiskDriver *driver,
+                                       GVirConfigDomainDiskType type,
+                                       int format)
+{
+    /* native AIO only stays asynchronous on preallocated storage */
+    gboolean preallocated = (type == GVIR_CONFIG_DOMAIN_DISK_BLOCK ||
+                             format == GVIR_CONFIG_DOMAIN_DISK_FORMAT_RAW);
+    gboolean io_uring = FALSE;
+
+    switch (design->priv->disk_profile) {
+    case GVIR_DESIGNER_DOMAIN_DISK_PROFILE_SAFE:
+        gvir_config_domain_disk_driver_set_cache(driver, GVIR_CONFIG_DOMAIN_DISK_CACHE_NONE);
+        gvir_config_domain_disk_driver_set_io_policy(driver,
+                                                     preallocated ?
+                                                     GVIR_CONFIG_DOMAIN_DISK_DRIVER_IO_POLICY_NATIVE :
+                                                     GVIR_CONFIG_DOMAIN_DISK_DRIVER_IO_POLICY_THREADS);
+        if (format == GVIR_CONFIG_DOMAIN_DISK_FORMAT_QCOW2)
+            gvir_config_domain_disk_driver_set_discard(driver,
+                                                       GVIR_CONFIG_DOMAIN_DISK_DRIVER_DISCARD_UNMAP);
+        break;
+    case GVIR_DESIGNER_DOMAIN_DISK_PROFILE_THROUGHPUT:
+        gvir_config_domain_disk_driver_set_cache(driver, GVIR_CONFIG_DOMAIN_DISK_CACHE_NONE);
+        gvir_config_domain_disk_driver_set_discard(driver,
+                                                   GVIR_CONFIG_DOMAIN_DISK_DRIVER_DISCARD_UNMAP);
+        io_uring = TRUE;
+        break;
+    case GVIR_DESIGNER_DOMAIN_DISK_PROFILE_LATENCY:
+        gvir_config_domain_disk_driver_set_cache(driver, GVIR_CONFIG_DOMAIN_DISK_CACHE_NONE);
+        if (preallocated)
+            gvir_config_domain_disk_driver_set_io_policy(driver,
+                                                         GVIR_CONFIG_DOMAIN_DISK_DRIVER_IO_POLICY_NATIVE);
+        else
+            io_uring = TRUE;
+        gvir_config_domain_disk_driver_set_discard(driver,
+                                                   GVIR_CONFIG_DOMAIN_DISK_DRIVER_DISCARD_IGNORE);
+        break;
+    case GVIR_DESIGNER_DOMAIN_DISK_PROFILE_SCRATCH:
+        gvir_config_domain_disk_driver_set_cache(driver, GVIR_CONFIG_DOMAIN_DISK_CACHE_UNSAFE);
+        gvir_config_domain_disk_driver_set_io_policy(driver,
+                                                     GVIR_CONFIG_DOMAIN_DISK_DRIVER_IO_POLICY_THREADS);
+        gvir_config_domain_disk_driver_set_discard(driver,
+                                                   GVIR_CONFIG_DOMAIN_DISK_DRIVER_DISCARD_UNMAP);
+        break;
+    case GVIR_DESIGNER_DOMAIN_DISK_PROFILE_NONE:
+    default:
+        break;
+    }
+
+    /* libvirt-gconfig predates io_uring */
+    if (io_uring)
+        gvir_designer_xml_set_attribute(gvir_designer_xml_get_node(GVIR_CONFIG_OBJECT(driver)),
+                                        "io", "io_uring");
+}
+
+
+static GVirConfigDomainDisk *
+gvir_designer_domain_add_disk_full(GVirDesignerDomain *design,
+                                   GVirConfigDomainDiskType type,
+                                   GVirConfigDomainDiskGuestDeviceType guest_type,
+                                   const char *path,
+                                   const char *format,
+                                   gchar *target,
+                                   GError **error)
+{
+    GVirDesignerDomainPrivate *priv = design->priv;
+    GVirConfigDomainDisk *disk = NULL;
+    GVirConfigDomainDiskDriver *driver = NULL;
+    GVirConfigDomainDiskBus bus;
+    gchar *target_gen = NULL;
+    const char *driver_name;
+    int virt_type;
+    /* libvirt treats disks without a format as raw */
+    int fmt = GVIR_CONFIG_DOMAIN_DISK_FORMAT_RAW;
+
+    OsinfoDevice *controller;
+
+    virt_type = gvir_config_domain_get_virt_type(priv->config);
+    switch (virt_type) {
+    case GVIR_CONFIG_DOMAIN_VIRT_QEMU:
+    case GVIR_CONFIG_DOMAIN_VIRT_KQEMU:
+    case GVIR_CONFIG_DOMAIN_VIRT_KVM:
+        driver_name = "qemu";
+        break;
+        /* add new virt type here */
+    default:
+        g_set_error(error, GVIR_DESIGNER_DOMAIN_ERROR, 0,
+                    "Unsupported virt type %d", virt_type);
+        goto error;
+        break;
+    }
+
+    driver = gvir_config_domain_disk_driver_new();
+    gvir_config_domain_disk_driver_set_name(driver, driver_name);
+    if (format) {
+        fmt = gvir_designer_genum_get_value(GVIR_CONFIG_TYPE_DOMAIN_DISK_FORMAT,
+                                            format, -1);
+
+        if (fmt == -1) {
+            g_set_error(error, GVIR_DESIGNER_DOMAIN_ERROR, 0,
+                        "Unknown disk format: %s", format);
+            goto error;
+        }
+
+        gvir_config_domain_disk_driver_set_format(driver, fmt);
+    }
+    if (guest_type == GVIR_CONFIG_DOMAIN_DISK_GUEST_DEVICE_DISK)
+        gvir_designer_domain_setup_disk_driver(design, driver, type, fmt);
+
+    disk = gvir_config_domain_disk_new();
+    gvir_config_domain_disk_set_type(disk, type);
+    gvir_config_domain_disk_set_source(disk, path);
+    gvir_config_domain_disk_set_driver(disk, driver);
+    g_object_unref(driver);
+    driver = NULL;
+
+    controller = gvir_designer_domain_get_preferred_disk_controller(design, NULL);
+    if (controller == NULL)
+        controller = gvir_designer_domain_get_fallback_disk_controller(design, NULL);
+
+    if (controller != NULL) {
+        bus = gvir_designer_domain_get_bus_type_from_controller(design, controller);
+        g_object_unref(controller);
+    } else {
+        bus = GVIR_CONFIG_DOMAIN_DISK_BUS_IDE;
+    }
+
+    if (bus == GVIR_CONFIG_DOMAIN_DISK_BUS_VIRTIO &&
+        priv->virtio_scsi_threshold > 0 &&
+        priv->n_virtio_disks >= priv->virtio_scsi_threshold &&
+        gvir_designer_domain_supports_virtio_scsi(design))
+        bus = GVIR_CONFIG_DOMAIN_DISK_BUS_SCSI;
+
+    gvir_config_domain_disk_set_target_bus(disk, bus);
+
+    if (!target) {
+        target = target_gen = gvir_designer_domain_next_disk_target(design, bus);
+        if (!target_gen) {
+            g_set_error(error, GVIR_DESIGNER_DOMAIN_ERROR, 0,
+                        "unable to generate target name for bus '%d'", bus);
+            goto error;
+        }
+    } else if (!gvir_designer_domain_reserve_disk_target(design, target, error)) {
+        goto error;
+    }
+    gvir_config_domain_disk_set_target_dev(disk, target);
+
+    g_free(target_gen);
+
+    if (bus == GVIR_CONFIG_DOMAIN_DISK_BUS_SCSI) {
+        if (!gvir_designer_domain_has_virtio_scsi_controller(design))
+            gvir_designer_domain_add_scsi_controller(design);
+        gvir_designer_domain_set_scsi_address(design, disk);
+    }
+
+    if (guest_type == GVIR_CONFIG_DOMAIN_DISK_GUEST_DEVICE_DISK)
+        gvir_designer_domain_setup_disk_discard(design, disk, bus);
+
+    if (bus == GVIR_CONFIG_DOMAIN_DISK_BUS_VIRTIO && priv->n_iothreads > 0)
+        gvir_designer_xml_set_attribute_uint(gvir_designer_xml_ensure_child(gvir_designer_xml_get_node(GVIR_CONFIG_OBJECT(disk)),
+                                                                            "driver"),
+                                             "iothread",
+                                             gvir_designer_domain_next_iothread(design));
+
+    gvir_config_domain_add_device(priv->config, GVIR_CONFIG_DOMAIN_DEVICE(disk));
+    if (guest_type == GVIR_CONFIG_DOMAIN_DISK_GUEST_DEVICE_DISK &&
+        bus == GVIR_CONFIG_DOMAIN_DISK_BUS_VIRTIO)
+        priv->n_virtio_disks++;
+
+    return disk;
+
+error:
+    g_free(target_gen);
+    if (driver != NULL)
+        g_object_unref(driver);
+    if (disk)
+        g_object_unref(disk);
+    return NULL;
+}
+
+
+/**
+ * gvir_designer_domain_add_disk_file:
+ * @design: (transfer none): the domain designer instance
+ * @filepath: (transfer none): the path to a file
+ * @format: (transfer none): disk format
+ * @error: return location for a #GError, or NULL
+ *
+ * Add a new disk to the domain.
+ *
+ * Returns: (transfer full): the pointer to new disk.
+ * If something fails NULL is returned and @error is set.
+ */
+GVirConfigDomainDisk *
+gvir_designer_domain_add_disk_file(GVirDesignerDomain *design,
+                                   const char *filepath,
+                                   const char *format,
+                                   GError **error)
+{
+    g_return_val_if_fail(GVIR_DESIGNER_IS_DOMAIN(design), NULL);
+
+    GVirConfigDomainDisk *ret = NULL;
+
+    ret = gvir_designer_domain_add_disk_full(design,
+                                             GVIR_CONFIG_DOMAIN_DISK_FILE,
+                                             GVIR_CONFIG_DOMAIN_DISK_GUEST_DEVICE_DISK,
+                                             filepath,
+                                             format,
+                                             NULL,
+                                             error);
+    return ret;
+}
+
+
+/**
+ * gvir_designer_domain_add_disk_device:
+ * @design: (transfer none): the domain designer instance
+ * @devpath: (transfer none): path to the device
+ * @error: return location for a #GError, or NULL
+ *
+ * Add given device as a new disk to the domain designer instance.
+ *
+ * Returns: (transfer full): the pointer to the new disk.
+ * If something fails NULL is returned and @error is set.
+ */
+GVirConfigDomainDisk *
+gvir_designer_domain_add_disk_device(GVirDesignerDomain *design,
+                                     const char *devpath,
+                                     GError **error)
+{
+    g_return_val_if_fail(GVIR_DESIGNER_IS_DOMAIN(design), NULL);
+
+    GVirConfigDomainDisk *ret = NULL;
+
+    ret = gvir_designer_domain_add_disk_full(design,
+                                             GVIR_CONFIG_DOMAIN_DISK_BLOCK,
+                                             GVIR_CONFIG_DOMAIN_DISK_GUEST_DEVICE_DISK,
+                                             devpath,
+                                             "raw",
+                                             NULL,
+                                             error);
+    return ret;
+}
+
+/**
+ * gvir_designer_domain_add_cdrom_file:
+ * @design: (transfer none): the domain designer instance
+ * @filepath: (transfer none): the path to a file
+ * @format: (transfer none): file format
+ * @error: return location for a #GError, or NULL
+ *
+ * Add a new disk to the domain.
+ *
+ * Returns: (transfer full): the pointer to new cdrom.
+ * If something fails NULL is returned and @error is set.
+ */
+GVirConfigDomainDisk *
+gvir_designer_domain_add_cdrom_file(GVirDesignerDomain *design,
+                                    const char *filepath,
+                                    const char *format,
+                                    GError **error)
+{
+    g_return_val_if_fail(GVIR_DESIGNER_IS_DOMAIN(design), NULL);
+
+    GVirConfigDomainDisk *ret = NULL;
+
+    ret = gvir_designer_domain_add_disk_full(design,
+                                             GVIR_CONFIG_DOMAIN_DISK_FILE,
+                                             GVIR_CONFIG_DOMAIN_DISK_GUEST_DEVICE_CDROM,
+                                             filepath,
+                                             format,
+                                             NULL,
+                                             error);
+    return ret;
+}
+
+
+/**
+ * gvir_designer_domain_add_cdrom_device:
+ * @design: (transfer none): the domain designer instance
+ * @devpath: (transfer none): path to the device
+ * @error: return location for a #GError, or NULL
+ *
+ * Add given device as a new cdrom to the domain designer instance.
+ *
+ * Returns: (transfer full): the pointer to the new cdrom.
+ * If something fails NULL is returned and @error is set.
+ */
+GVirConfigDomainDisk *
+gvir_designer_domain_add_cdrom_device(GVirDesignerDomain *design,
+                                      const char *devpath,
+                                      GError **error)
+{
+    g_return_val_if_fail(GVIR_DESIGNER_IS_DOMAIN(design), NULL);
+
+    GVirConfigDomainDisk *ret = NULL;
+
+    ret = gvir_designer_domain_add_disk_full(design,
+                                             GVIR_CONFIG_DOMAIN_DISK_BLOCK,
+                                             GVIR_CONFIG_DOMAIN_DISK_GUEST_DEVICE_CDROM,
+                                             devpath,
+                                             "raw",
+                                             NULL,
+                                             error);
+    return ret;
+}
+
+
+/**
+ * gvir_designer_domain_add_floppy_file:
+ * @design: (transfer none): the domain designer instance
+ * @filepath: (transfer none): the path to a file
+ * @format: (transfer none): file format
+ * @error: return location for a #GError, or NULL
+ *
+ * Add a new disk to the domain.
+ *
+ * Returns: (transfer full): the pointer to new floppy.
+ * If something fails NULL is returned and @error is set.
+ */
+GVirConfigDomainDisk *
+gvir_designer_domain_add_floppy_file(GVirDesignerDomain *design,
+                                     const char *filepath,
+                                     const char *format,
+                                     GError **error)
+{
+    g_return_val_if_fail(GVIR_DESIGNER_IS_DOMAIN(design), NULL);
+
+    GVirConfigDomainDisk *ret = NULL;
+
+    ret = gvir_designer_domain_add_disk_full(design,
+                                             GVIR_CONFIG_DOMAIN_DISK_FILE,
+                                             GVIR_CONFIG_DOMAIN_DISK_GUEST_DEVICE_FLOPPY,
+                                             filepath,
+                                             format,
+                                             NULL,
+                                             error);
+    return ret;
+}
+
+
+/**
+ * gvir_designer_domain_add_floppy_device:
+ * @design: (transfer none): the domain designer instance
+ * @devpath: (transfer none): path to the device
+ * @error: return location for a #GError, or NULL
+ *
+ * Add given device as a new floppy to the domain designer instance.
+ *
+ * Returns: (transfer full): the pointer to the new floppy.
+ * If something fails NULL is returned and @error is set.
+ */
+GVirConfigDomainDisk *
+gvir_designer_domain_add_floppy_device(GVirDesignerDomain *design,
+                                       const char *devpath,
+                                       GError **error)
+{
+    g_return_val_if_fail(GVIR_DESIGNER_IS_DOMAIN(design), NULL);
+
+    GVirConfigDomainDisk *ret = NULL;
+
+    ret = gvir_designer_domain_add_disk_full(design,
+                                             GVIR_CONFIG_DOMAIN_DISK_BLOCK,
+                                             GVIR_CONFIG_DOMAIN_DISK_GUEST_DEVICE_FLOPPY,
+                                             devpath,
+                                             "raw",
+                                             NULL,
+                                             error);
+    return ret;
+}
+
+
+
+static const gchar *
+gvir_designer_domain_get_preferred_nic_model(GVirDesignerDomain *design,
+                                             GError **error)
+{
+    const gchar *ret = NULL;
+    OsinfoDeviceLink *dev_link = NULL;
+
+    dev_link = gvir_designer_domain_get_preferred_device(design, "network", error);
+    if (!dev_link)
+        goto cleanup;
+
+    ret = osinfo_devicelink_get_driver(dev_link);
+
+cleanup:
+    if (dev_link)
+        g_object_unref(dev_link);
+    return ret;
+}
+
+
+/**
+ * gvir_designer_domain_set_nic_queues:
+ * @design: (transfer none): the domain designer instance
+ * @queues: number of queue pairs, or 0
+ *
+ * Sets the number of queue pairs of the virtio network interfaces added
+ * from now on. The default, 0, uses one queue pair per vCPU, with a
+ * maximum of 8, when the OS supports the virtio 1.0 network device and
+ * a single queue pair otherwise. It only applies to KVM domains, where
+ * such interfaces use the vhost-net backend.
+ */
+void
+gvir_designer_domain_set_nic_queues(GVirDesignerDomain *design,
+                                    guint queues)
+{
+    g_return_if_fail(GVIR_DESIGNER_IS_DOMAIN(design));
+
+    design->priv->nic_queues = queues;
+}
+
+
+/* @name is the backend, NULL when QEMU does not pick it (vhost-user) */
+static void
+gvir_designer_domain_setup_nic_driver(GVirDesignerDomain *design,
+                                      GVirConfigDomainInterface *iface,
+                                      const char *name)
+{
+    xmlNodePtr driver;
+    guint queues = design->priv->nic_queues;
+
+    if (gvir_config_domain_get_virt_type(design->priv->config) !=
+        GVIR_CONFIG_DOMAIN_VIRT_KVM)
+        return;
+
+    /* libosinfo does not tell which drivers handle multiqueue, those of
+     * the virtio 1.0 device all do, older ones may not */
+    if (queues == 0 &&
+        gvir_designer_domain_supports_qemu_device(design,
+                                                  GVIR_DESIGNER_VIRTIO1_NET_DEVICE_ID))
+        queues = MIN(gvir_config_domain_get_vcpus(design->priv->config),
+                     GVIR_DESIGNER_NIC_MAX_QUEUES);
+    if (!name && queues <= 1)
+        return;
+
+    g_debug("Using %s backend with %u queues", name ? name : "default", queues);
+
+    driver = gvir_designer_xml_ensure_child(gvir_designer_xml_get_node(GVIR_CONFIG_OBJECT(iface)),
+                                            "driver");
+    gvir_designer_xml_set_attribute(driver, "name", name);
+    if (queues > 1)
+        gvir_designer_xml_set_attribute_uint(driver, "queues", queues);
+    else
+        gvir_designer_xml_set_attribute(driver, "queues", NULL);
+}
+
+
+static gboolean
+gvir_designer_domain_check_nic_backend(GVirDesignerDomain *design,
+                                       GVirDesignerDomainNICType type,
+                                       const gchar *model,
+                                       GError **error)
+{
+    int virt_type = gvir_config_domain_get_virt_type(design->priv->config);
+    const char *name = (type == GVIR_DESIGNER_DOMAIN_NIC_TYPE_DIRECT) ?
+        "direct" : "vhost-user";
+
+    if (virt_type != GVIR_CONFIG_DOMAIN_VIRT_QEMU &&
+        virt_type != GVIR_CONFIG_DOMAIN_VIRT_KVM) {
+        g_set_error(error, GVIR_DESIGNER_DOMAIN_ERROR, 0,
+                    "Virt type %d does not support %s interfaces",
+                    virt_type, name);
+        return FALSE;
+    }
+
+    /* the vhost-user protocol is virtio's ring layout */
+    if (type == GVIR_DESIGNER_DOMAIN_NIC_TYPE_VHOSTUSER &&
+        g_strcmp0(model, "virtio") != 0) {
+        g_set_error(error, GVIR_DESIGNER_DOMAIN_ERROR, 0,
+                    "OS '%s' has no virtio network driver, required by %s interfaces",
+                    osinfo_entity_get_id(OSINFO_ENTITY(design->priv->os)),
+                    name);
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+
+/* libvirt-gconfig has classes for bridge, network and user interfaces
+ * only, the other types are user interfaces with their type changed */
+static GVirConfigDomainInterface *
+gvir_designer_domain_create_interface(const char *type)
+{
+    GVirConfigDomainInterface *iface;
+
+    iface = GVIR_CONFIG_DOMAIN_INTERFACE(gvir_config_domain_interface_user_new());
+    gvir_designer_xml_set_attribute(gvir_designer_xml_get_node(GVIR_CONFIG_OBJECT(iface)),
+                                    "type", type);
+
+    return iface;
+}
+
+
+/* vhost-user back-ends access guest RAM directly, which must thus be
+ * shared with them rather than private to QEMU */
+static void
+gvir_designer_domain_setup_shared_memory(GVirDesignerDomain *design)
+{
+    xmlNodePtr backing;
+
+    backing = gvir_designer_xml_ensure_child(gvir_designer_xml_get_node(GVIR_CONFIG_OBJECT(design->priv->config)),
+                                             "memoryBacking");
+    /* hugepages come from hugetlbfs files, which can be shared as is */
+    if (!gvir_designer_xml_get_child(backing, "hugepages") &&
+        !gvir_designer_xml_get_child(backing, "source"))
+        gvir_designer_xml_set_attribute(gvir_designer_xml_add_child(backing, "source"),
+                                        "type", "memfd");
+    gvir_designer_xml_set_attribute(gvir_designer_xml_ensure_child(backing, "access"),
+                                    "mode", "shared");
+}
+
+
+static GVirConfigDomainInterface *
+gvir_designer_domain_add_interface_full(GVirDesignerDomain *design,
+                                        GVirDesignerDomainNICType type,
+                                        const char *source,
+                                        GError **error)
+{
+    GVirConfigDomainInterface *ret = NULL;
+    const gchar *model = NULL;
+    GError *model_error = NULL;
+    xmlNodePtr node;
+
+    model = gvir_designer_domain_get_preferred_nic_model(design, &model_error);
+
+    if (type == GVIR_DESIGNER_DOMAIN_NIC_TYPE_DIRECT ||
+        type == GVIR_DESIGNER_DOMAIN_NIC_TYPE_VHOSTUSER) {
+        if (model_error) {
+            g_propagate_error(error, model_error);
+            goto cleanup;
+        }
+        if (!gvir_designer_domain_check_nic_backend(design, type, model, error))
+            goto cleanup;
+    } else if (model_error) {
+        g_propagate_error(error, model_error);
+    }
+
+    switch (type) {
+    case GVIR_DESIGNER_DOMAIN_NIC_TYPE_BRIDGE:
+        ret = GVIR_CONFIG_DOMAIN_INTERFACE(gvir_config_domain_interface_bridge_new());
+        gvir_config_domain_interface_bridge_set_source(GVIR_CONFIG_DOMAIN_INTERFACE_BRIDGE(ret),
+                                                       source);
+        break;
+    case GVIR_DESIGNER_DOMAIN_NIC_TYPE_NETWORK:
+        ret = GVIR_CONFIG_DOMAIN_INTERFACE(gvir_config_domain_interface_network_new());
+        gvir_config_domain_interface_network_set_source(GVIR_CONFIG_DOMAIN_INTERFACE_NETWORK(ret),
+                                                        source);
+        break;
+    case GVIR_DESIGNER_DOMAIN_NIC_TYPE_USER:
+        ret = GVIR_CONFIG_DOMAIN_INTERFACE(gvir_config_domain_interface_user_new());
+        break;
+    case GVIR_DESIGNER_DOMAIN_NIC_TYPE_DIRECT:
+        ret = gvir_designer_domain_create_interface("direct");
+        node = gvir_designer_xml_add_child(gvir_designer_xml_get_node(GVIR_CONFIG_OBJECT(ret)),
+                                           "source");
+        gvir_designer_xml_set_attribute(node, "dev", source);
+        gvir_designer_xml_set_attribute(node, "mode", "bridge");
+        break;
+    case GVIR_DESIGNER_DOMAIN_NIC_TYPE_VHOSTUSER:
+        ret = gvir_designer_domain_create_interface("vhostuser");
+        node = gvir_designer_xml_add_child(gvir_designer_xml_get_node(GVIR_CONFIG_OBJECT(ret)),
+                                           "source");
+        gvir_designer_xml_set_attribute(node, "type", "unix");
+        gvir_designer_xml_set_attribute(node, "path", source);
+        gvir_designer_xml_set_attribute(node, "mode", "client");
+        gvir_designer_domain_setup_shared_memory(design);
+        break;
+    default:
+        g_set_error(error, GVIR_DESIGNER_DOMAIN_ERROR, 0,
+                    "Unsupported interface type '%d'", type);
+        goto cleanup;
+    }
+
+    if (model)
+        gvir_config_domain_interface_set_model(ret, model);
+
+    /* user networking runs inside QEMU, vhost needs a tap device */
+    if (g_strcmp0(model, "virtio") == 0) {
+        if (type == GVIR_DESIGNER_DOMAIN_NIC_TYPE_VHOSTUSER)
+            gvir_designer_domain_setup_nic_driver(design, ret, NULL);
+        else if (type != GVIR_DESIGNER_DOMAIN_NIC_TYPE_USER)
+            gvir_designer_domain_setup_nic_driver(design, ret, "vhost");
+    }
+
+    gvir_config_domain_add_device(design->priv->config, GVIR_CONFIG_DOMAIN_DEVICE(ret));
+
+cleanup:
+    return ret;
+}
+
+/**
+ * gvir_designer_domain_add_interface_bridge:
+ * @design: (transfer none): the domain designer instance
+ * @bridge: (transfer none): bridge name
+ * @error: return location for a #GError, or NULL
+ *
+ * Add new network interface card into @design. The interface is
+ * of 'bridge' type and uses @bridge as the bridge device
+ *
+ * Returns: (transfer full): the pointer to the new interface.
+ */
+GVirConfigDomainInterface *
+gvir_designer_domain_add_interface_bridge(GVirDesignerDomain *design,
+                                          const char *bridge,
+                                          GError **error)
+{
+    g_return_val_if_fail(GVIR_DESIGNER_IS_DOMAIN(design), NULL);
+    g_return_val_if_fail(bridge != NULL, NULL);
+    g_return_val_if_fail(!error_is_set(error), NULL);
+
+    GVirConfigDomainInterface *ret = NULL;
+
+    ret = gvir_designer_domain_add_interface_full(design,
+                                                  GVIR_DESIGNER_DOMAIN_NIC_TYPE_BRIDGE,
+                                                  bridge,
+                                                  error);
+
+    return ret;
+}
+
+/**
+ * gvir_designer_domain_add_interface_network:
+ * @design: (transfer none): the domain designer instance
+ * @network: (transfer none): network name
+ * @error: return location for a #GError, or NULL
+ *
+ * Add new network interface card into @design. The interface is
+ * of 'network' type with @network used as the source network.
+ *
+ * Returns: (transfer full): the pointer to the new interface.
+ */
+GVirConfigDomainInterface *
+gvir_designer_domain_add_interface_network(GVirDesignerDomain *design,
+                                           const char *network,
+                                           GError **error)
+{
+    g_return_val_if_fail(GVIR_DESIGNER_IS_DOMAIN(design), NULL);
+    g_return_val_if_fail(network != NULL, NULL);
+    g_return_val_if_fail(!error_is_set(error), NULL);
 
     GVirConfigDomainInterface *ret = NULL;
 
-    ret = gvir_designer_domain_add_interface_full(design,
-                                                  GVIR_DESIGNER_DOMAIN_NIC_TYPE_BRIDGE,
-                                                  bridge,
-                                                  error);
+    ret = gvir_designer_domain_add_interface_full(design,
+                                                  GVIR_DESIGNER_DOMAIN_NIC_TYPE_NETWORK,
+                                                  network,
+                                                  error);
+
+    return ret;
+}
+
+/**
+ * gvir_designer_domain_add_interface_user:
+ * @design: (transfer none): the domain designer instance
+ * @error: return location for a #GError, or NULL
+ *
+ * Add new network interface card into @design. The interface is
+ * of 'user' type.
+ *
+ * Returns: (transfer full): the pointer to the new interface.
+ */
+GVirConfigDomainInterface *
+gvir_designer_domain_add_interface_user(GVirDesignerDomain *design,
+                                        GError **error)
+{
+    g_return_val_if_fail(GVIR_DESIGNER_IS_DOMAIN(design), NULL);
+    g_return_val_if_fail(!error_is_set(error), NULL);
+
+    GVirConfigDomainInterface *ret = NULL;
+
+    ret = gvir_designer_domain_add_interface_full(design,
+                                                  GVIR_DESIGNER_DOMAIN_NIC_TYPE_USER,
+                                                  NULL,
+                                                  error);
+
+    return ret;
+}
+
+/**
+ * gvir_designer_domain_add_interface_direct:
+ * @design: (transfer none): the domain designer instance
+ * @dev: (transfer none): host network device name
+ * @error: return location for a #GError, or NULL
+ *
+ * Add new network interface card into @design. The interface is
+ * of 'direct' type: a macvtap device in bridge mode on top of @dev,
+ * which saves the host bridge hop. The guest cannot talk to the host
+ * through it. Only QEMU and KVM domains support it.
+ *
+ * Returns: (transfer full): the pointer to the new interface.
+ */
+GVirConfigDomainInterface *
+gvir_designer_domain_add_interface_direct(GVirDesignerDomain *design,
+                                          const char *dev,
+                                          GError **error)
+{
+    g_return_val_if_fail(GVIR_DESIGNER_IS_DOMAIN(design), NULL);
+    g_return_val_if_fail(dev != NULL, NULL);
+    g_return_val_if_fail(!error_is_set(error), NULL);
+
+    return gvir_designer_domain_add_interface_full(design,
+                                                   GVIR_DESIGNER_DOMAIN_NIC_TYPE_DIRECT,
+                                                   dev,
+                                                   error);
+}
+
+/**
+ * gvir_designer_domain_add_interface_vhostuser:
+ * @design: (transfer none): the domain designer instance
+ * @socket_path: (transfer none): path of the back-end's UNIX socket
+ * @error: return location for a #GError, or NULL
+ *
+ * Add new network interface card into @design. The interface is
+ * of 'vhostuser' type: its queues are served by a user space process
+ * (a DPDK switch for instance) listening on @socket_path. The guest
+ * memory is made shareable with that process. Only QEMU and KVM
+ * domains whose OS has a virtio network driver support it.
+ *
+ * Returns: (transfer full): the pointer to the new interface.
+ */
+GVirConfigDomainInterface *
+gvir_designer_domain_add_interface_vhostuser(GVirDesignerDomain *design,
+                                             const char *socket_path,
+                                             GError **error)
+{
+    g_return_val_if_fail(GVIR_DESIGNER_IS_DOMAIN(design), NULL);
+    g_return_val_if_fail(socket_path != NULL, NULL);
+    g_return_val_if_fail(!error_is_set(error), NULL);
+
+    return gvir_designer_domain_add_interface_full(design,
+                                                   GVIR_DESIGNER_DOMAIN_NIC_TYPE_VHOSTUSER,
+                                                   socket_path,
+                                                   error);
+}
+
+/* libvirt-gconfig has no virtio video model, @virtio is set instead and
+ * VGA, the model virtio-vga falls back to, is returned */
+static GVirConfigDomainVideoModel
+gvir_designer_domain_video_model_str_to_enum(const char *model_str,
+                                             gboolean *virtio,
+                                             GError **error)
+{
+    GVirConfigDomainVideoModel model;
+
+    *virtio = FALSE;
+    if (g_str_equal(model_str, "vga")) {
+        model = GVIR_CONFIG_DOMAIN_VIDEO_MODEL_VGA;
+    } else if (g_str_equal(model_str, "cirrus")) {
+        model = GVIR_CONFIG_DOMAIN_VIDEO_MODEL_CIRRUS;
+    } else if (g_str_equal(model_str, "vmvga")) {
+        model = GVIR_CONFIG_DOMAIN_VIDEO_MODEL_VMVGA;
+    } else if (g_str_equal(model_str, "xen")) {
+        model = GVIR_CONFIG_DOMAIN_VIDEO_MODEL_XEN;
+    } else if (g_str_equal(model_str, "vbox")) {
+        model = GVIR_CONFIG_DOMAIN_VIDEO_MODEL_VBOX;
+    } else if (g_str_equal(model_str, "qxl")) {
+        model = GVIR_CONFIG_DOMAIN_VIDEO_MODEL_QXL;
+    } else if (g_str_equal(model_str, "virtio-gpu") ||
+               g_str_equal(model_str, "virtio1.0-gpu")) {
+        model = GVIR_CONFIG_DOMAIN_VIDEO_MODEL_VGA;
+        *virtio = TRUE;
+    } else {
+        g_debug("unsupported video model type '%s'", model_str);
+        g_set_error(error, GVIR_DESIGNER_DOMAIN_ERROR, 0,
+                    "unsupported video model type '%s'", model_str);
+        model = GVIR_CONFIG_DOMAIN_VIDEO_MODEL_VGA;
+    }
+
+    return model;
+}
+
+/* FIXME: belongs in platform descriptions, maybe useful as a last resort */
+static GVirConfigDomainVideoModel
+gvir_designer_domain_video_model_from_virt_type(GVirDesignerDomain *design)
+{
+    GVirConfigDomainVirtType virt_type;
+    GVirConfigDomainVideoModel model;
+
+    virt_type = gvir_config_domain_get_virt_type(design->priv->config);
+    switch (virt_type) {
+    case GVIR_CONFIG_DOMAIN_VIRT_QEMU:
+    case GVIR_CONFIG_DOMAIN_VIRT_KQEMU:
+    case GVIR_CONFIG_DOMAIN_VIRT_KVM:
+        model = GVIR_CONFIG_DOMAIN_VIDEO_MODEL_QXL;
+        break;
+    case GVIR_CONFIG_DOMAIN_VIRT_XEN:
+        model = GVIR_CONFIG_DOMAIN_VIDEO_MODEL_XEN;
+        break;
+    case GVIR_CONFIG_DOMAIN_VIRT_VMWARE:
+        model = GVIR_CONFIG_DOMAIN_VIDEO_MODEL_VMVGA;
+        break;
+    case GVIR_CONFIG_DOMAIN_VIRT_VBOX:
+        model = GVIR_CONFIG_DOMAIN_VIDEO_MODEL_VBOX;
+        break;
+    case GVIR_CONFIG_DOMAIN_VIRT_LXC:
+    case GVIR_CONFIG_DOMAIN_VIRT_UML:
+    case GVIR_CONFIG_DOMAIN_VIRT_OPENVZ:
+    case GVIR_CONFIG_DOMAIN_VIRT_VSERVER:
+    case GVIR_CONFIG_DOMAIN_VIRT_LDOM:
+    case GVIR_CONFIG_DOMAIN_VIRT_TEST:
+    case GVIR_CONFIG_DOMAIN_VIRT_HYPERV:
+    case GVIR_CONFIG_DOMAIN_VIRT_ONE:
+    case GVIR_CONFIG_DOMAIN_VIRT_PHYP:
+        model = GVIR_CONFIG_DOMAIN_VIDEO_MODEL_VGA;
+        break;
+    default:
+        g_warn_if_reached();
+        model = GVIR_CONFIG_DOMAIN_VIDEO_MODEL_VGA;
+        break;
+    }
+
+    return model;
+}
+
+static const gchar *
+gvir_designer_domain_get_preferred_video_model(GVirDesignerDomain *design,
+                                               GError **error)
+{
+    const gchar *ret = NULL;
+    OsinfoDeviceLink *dev_link = NULL;
+    OsinfoDevice *dev;
+
+    dev_link = gvir_designer_domain_get_preferred_device(design, "video", error);
+    if (!dev_link)
+        goto cleanup;
+
+    dev = osinfo_devicelink_get_target(dev_link);
+    if (dev)
+        ret = osinfo_device_get_name(dev);
+
+cleanup:
+    if (dev_link)
+        g_object_unref(dev_link);
+    return ret;
+}
+
+/* only QEMU knows the virtio video model */
+static gboolean
+gvir_designer_domain_virt_type_is_qemu(GVirDesignerDomain *design)
+{
+    GVirConfigDomainVirtType virt_type;
+
+    virt_type = gvir_config_domain_get_virt_type(design->priv->config);
+    return virt_type == GVIR_CONFIG_DOMAIN_VIRT_QEMU ||
+           virt_type == GVIR_CONFIG_DOMAIN_VIRT_KVM;
+}
+
+static GVirConfigDomainVideoModel
+gvir_designer_domain_get_fallback_video_model(GVirDesignerDomain *design,
+                                              gboolean *virtio)
+{
+    OsinfoDeviceList *supported_devices = NULL;
+    OsinfoFilter *filter = NULL;
+    OsinfoDevice *device = NULL;
+    const char *model_str;
+    GVirConfigDomainVideoModel model;
+    GError *error = NULL;
+
+    model = GVIR_CONFIG_DOMAIN_VIDEO_MODEL_VGA;
+    *virtio = FALSE;
+
+    filter = osinfo_filter_new();
+    osinfo_filter_add_constraint(filter, OSINFO_DEVICE_PROP_CLASS, "video");
+    supported_devices = gvir_designer_domain_get_supported_devices(design, filter);
+    if (supported_devices == NULL || osinfo_list_get_length(OSINFO_LIST(supported_devices)) == 0)
+        goto fallback;
+
+    device = OSINFO_DEVICE(osinfo_list_get_nth(OSINFO_LIST(supported_devices), 0));
+    model_str = osinfo_device_get_name(device);
+    model = gvir_designer_domain_video_model_str_to_enum(model_str,
+                                                         virtio,
+                                                         &error);
+    if (error != NULL) {
+        g_clear_error(&error);
+        goto fallback;
+    }
+    if (*virtio && !gvir_designer_domain_virt_type_is_qemu(design))
+        goto fallback;
+    goto end;
+
+fallback:
+    *virtio = FALSE;
+    model = gvir_designer_domain_video_model_from_virt_type(design);
+
+end:
+    if (filter != NULL)
+        g_object_unref(G_OBJECT(filter));
+    if (supported_devices != NULL)
+        g_object_unref(G_OBJECT(supported_devices));
+
+    return model;
+}
+
+static GVirConfigDomainVideoModel
+gvir_designer_domain_get_video_model(GVirDesignerDomain *design,
+                                     gboolean *virtio)
+{
+    const gchar *model_str;
+    GVirConfigDomainVideoModel model;
+    GError *error = NULL;
+
+    model_str = gvir_designer_domain_get_preferred_video_model(design, NULL);
+    if (model_str == NULL)
+        return gvir_designer_domain_get_fallback_video_model(design, virtio);
+
+    model = gvir_designer_domain_video_model_str_to_enum(model_str, virtio,
+                                                         &error);
+    if (error != NULL) {
+        g_clear_error(&error);
+        model = gvir_designer_domain_get_fallback_video_model(design, virtio);
+    } else if (*virtio && !gvir_designer_domain_virt_type_is_qemu(design)) {
+        model = gvir_designer_domain_get_fallback_video_model(design, virtio);
+    }
+
+    return model;
+}
+
+/* Video memory in KiB for @bytes of framebuffer, rounded up to a power
+ * of two MiB as that is what the emulated devices map */
+static guint
+gvir_designer_video_mem_kib(guint64 bytes)
+{
+    guint mib = 1;
+
+    while ((guint64)mib * 1024 * 1024 < bytes)
+        mib *= 2;
+
+    return mib * 1024;
+}
+
+static GVirConfigDomainVideo *
+gvir_designer_domain_create_video(GVirConfigDomainVideoModel model,
+                                  gboolean virtio,
+                                  guint width,
+                                  guint height,
+                                  guint heads)
+{
+    GVirConfigDomainVideo *video;
+    xmlNodePtr node;
+    guint64 head_bytes = (guint64)width * height * 4;
+
+    video = gvir_config_domain_video_new();
+    gvir_config_domain_video_set_model(video, model);
+
+    if (heads > 1)
+        gvir_config_domain_video_set_heads(video, heads);
+
+    /* libvirt-gconfig knows neither the virtio model nor the ram and
+     * vgamem sizes */
+    node = gvir_designer_xml_get_child(gvir_designer_xml_get_node(GVIR_CONFIG_OBJECT(video)),
+                                       "model");
+    if (virtio)
+        gvir_designer_xml_set_attribute(node, "type", "virtio");
+
+    if (head_bytes == 0 || virtio)
+        return video;
+
+    switch (model) {
+    case GVIR_CONFIG_DOMAIN_VIDEO_MODEL_QXL:
+        /* vgamem backs the VGA mode framebuffer of the first head, ram
+         * the primary surfaces of all the heads plus the command rings,
+         * vram the off-screen surfaces */
+        gvir_config_domain_video_set_vram(video,
+                                          gvir_designer_video_mem_kib(head_bytes * heads));
+        gvir_designer_xml_set_attribute_uint(node, "ram",
+                                             2 * gvir_designer_video_mem_kib(head_bytes * heads));
+        gvir_designer_xml_set_attribute_uint(node, "vgamem",
+                                             gvir_designer_video_mem_kib(head_bytes));
+        break;
+    case GVIR_CONFIG_DOMAIN_VIDEO_MODEL_CIRRUS:
+        /* fixed size */
+        break;
+    default:
+        gvir_config_domain_video_set_vram(video,
+                                          gvir_designer_video_mem_kib(head_bytes * heads));
+        break;
+    }
+
+    return video;
+}
+
+/**
+ * gvir_designer_domain_add_video:
+ * @design: (transfer none): the domain designer instance
+ * @error: return location for a #GError, or NULL
+ *
+ * Add a new video device into @design. Its memory is left to the
+ * hypervisor defaults, see gvir_designer_domain_add_video_full().
+ *
+ * Returns: (transfer full): the pointer to the new video device.
+ */
+GVirConfigDomainVideo *
+gvir_designer_domain_add_video(GVirDesignerDomain *design,
+                               GError **error)
+{
+    return gvir_designer_domain_add_video_full(design, 0, 0, 1, error);
+}
+
+/**
+ * gvir_designer_domain_add_video_full:
+ * @design: (transfer none): the domain designer instance
+ * @width: largest horizontal resolution of a head, in pixels
+ * @height: largest vertical resolution of a head, in pixels
+ * @heads: number of displays
+ * @error: return location for a #GError, or NULL
+ *
+ * Add a new video device into @design, driving @heads displays of up to
+ * @width x @height pixels each. The model is the one libosinfo prefers
+ * for the OS, virtio included, and its video memory is the smallest
+ * fitting the displays. When @width and @height are 0 the memory is left
+ * to the hypervisor defaults.
+ *
+ * Windows drivers only handle a single head per QXL device, so for
+ * Windows guests one device per head is added instead.
+ *
+ * Returns: (transfer full): the pointer to the new video device, which
+ * drives the first head.
+ */
+GVirConfigDomainVideo *
+gvir_designer_domain_add_video_full(GVirDesignerDomain *design,
+                                    guint width,
+                                    guint height,
+                                    guint heads,
+                                    GError **error)
+{
+    GVirConfigDomainVideo *video;
+    GVirConfigDomainVideoModel model;
+    gboolean virtio;
+    guint n_devices = 1;
+    guint i;
+
+    g_return_val_if_fail(GVIR_DESIGNER_IS_DOMAIN(design), NULL);
+    g_return_val_if_fail(!error_is_set(error), NULL);
+
+    if ((width == 0) != (height == 0) || heads == 0) {
+        g_set_error(error, GVIR_DESIGNER_DOMAIN_ERROR, 0,
+                    "invalid display size %ux%u with %u heads",
+                    width, height, heads);
+        return NULL;
+    }
+
+    model = gvir_designer_domain_get_video_model(design, &virtio);
+
+    if (heads > 1 && !virtio &&
+        model != GVIR_CONFIG_DOMAIN_VIDEO_MODEL_QXL &&
+        model != GVIR_CONFIG_DOMAIN_VIDEO_MODEL_VBOX) {
+        g_set_error(error, GVIR_DESIGNER_DOMAIN_ERROR, 0,
+                    "video model does not support %u heads", heads);
+        return NULL;
+    }
+
+    if (model == GVIR_CONFIG_DOMAIN_VIDEO_MODEL_QXL && !virtio &&
+        gvir_designer_domain_is_windows(design)) {
+        n_devices = heads;
+        heads = 1;
+    }
+
+    /* the first video device is the primary one */
+    video = gvir_designer_domain_create_video(model, virtio,
+                                              width, height, heads);
+    gvir_config_domain_add_device(design->priv->config,
+                                  GVIR_CONFIG_DOMAIN_DEVICE(video));
+
+    for (i = 1; i < n_devices; i++) {
+        GVirConfigDomainVideo *secondary;
+
+        secondary = gvir_designer_domain_create_video(model, FALSE,
+                                                      width, height, 1);
+        gvir_config_domain_add_device(design->priv->config,
+                                      GVIR_CONFIG_DOMAIN_DEVICE(secondary));
+        g_object_unref(secondary);
+    }
+
+    return video;
+}
+
+
+static void
+gvir_designer_domain_get_resources(OsinfoResourcesList *res_list,
+                                   const gchar *design_arch,
+                                   gint *design_n_cpus,
+                                   gint64 *design_ram)
+{
+    GList *elem_list, *elem_iterator;
+
+    if (!res_list)
+        return;
+
+    elem_list = osinfo_list_get_elements(OSINFO_LIST(res_list));
+    for (elem_iterator = elem_list; elem_iterator; elem_iterator = elem_iterator->next) {
+        OsinfoResources *res = OSINFO_RESOURCES(elem_iterator->data);
+        const char *arch = osinfo_resources_get_architecture(res);
+        gint n_cpus = -1;
+        gint64 ram = -1;
+
+        if (g_str_equal(arch, "all") ||
+            g_str_equal(arch, design_arch)) {
+            n_cpus = osinfo_resources_get_n_cpus(res);
+            ram = osinfo_resources_get_ram(res);
+            if (n_cpus > 0) {
+                *design_n_cpus = n_cpus;
+            }
+            if (ram > 0) {
+                /* libosinfo returns RAM in B, libvirt-gconfig takes it in KB */
+                *design_ram = ram / 1024;
+            }
+            break;
+        }
+    }
+    g_list_free(elem_list);
+}
+
+
+/* Model name of the host CPU in the capabilities */
+static gchar *
+gvir_designer_domain_get_host_cpu_model(GVirDesignerDomain *design)
+{
+    xmlNodePtr node;
+    xmlChar *content;
+    gchar *model = NULL;
+
+    node = gvir_designer_xml_get_child(gvir_designer_xml_get_node(GVIR_CONFIG_OBJECT(design->priv->caps)),
+                                       "host");
+    if (node)
+        node = gvir_designer_xml_get_child(node, "cpu");
+    if (node)
+        node = gvir_designer_xml_get_child(node, "model");
+    if (node == NULL)
+        return NULL;
+
+    content = xmlNodeGetContent(node);
+    if (content && *content)
+        model = g_strdup((const gchar *)content);
+    xmlFree(content);
+
+    return model;
+}
+
+
+/**
+ * gvir_designer_domain_setup_cpu:
+ * @design: (transfer none): the domain designer instance
+ * @mode: the CPU model policy
+ * @error: return location for a #GError, or NULL
+ *
+ * Sets the CPU model the guest sees:
+ *
+ * GVIR_DESIGNER_DOMAIN_CPU_MODE_HOST_PASSTHROUGH exposes the host CPU
+ * as is, with every feature it has. It is the fastest, but the guest
+ * can only migrate to identical hosts.
+ *
+ * GVIR_DESIGNER_DOMAIN_CPU_MODE_HOST_MODEL exposes the closest named
+ * model plus the host features, which libvirt can recreate on other
+ * hosts of the same or a newer generation.
+ *
+ * GVIR_DESIGNER_DOMAIN_CPU_MODE_CUSTOM exposes the named model the
+ * capabilities report for the host CPU, without its extra features.
+ *
+ * GVIR_DESIGNER_DOMAIN_CPU_MODE_AUTO picks host-passthrough for KVM
+ * domains and keeps the hypervisor's default CPU model otherwise, as
+ * emulation cannot provide the host features.
+ *
+ * The first two modes need a KVM domain, so call this after
+ * gvir_designer_domain_setup_machine().
+ *
+ * Returns: TRUE on success, FALSE with @error set otherwise.
+ */
+gboolean
+gvir_designer_domain_setup_cpu(GVirDesignerDomain *design,
+                               GVirDesignerDomainCpuMode mode,
+                               GError **error)
+{
+    xmlNodePtr cpu;
+    xmlNodePtr model;
+    gchar *name = NULL;
+    gboolean kvm;
+
+    g_return_val_if_fail(GVIR_DESIGNER_IS_DOMAIN(design), FALSE);
+    g_return_val_if_fail(!error_is_set(error), FALSE);
+
+    kvm = (gvir_config_domain_get_virt_type(design->priv->config) ==
+           GVIR_CONFIG_DOMAIN_VIRT_KVM);
+
+    switch (mode) {
+    case GVIR_DESIGNER_DOMAIN_CPU_MODE_AUTO:
+        if (!kvm)
+            return TRUE;
+        mode = GVIR_DESIGNER_DOMAIN_CPU_MODE_HOST_PASSTHROUGH;
+        break;
+    case GVIR_DESIGNER_DOMAIN_CPU_MODE_HOST_PASSTHROUGH:
+    case GVIR_DESIGNER_DOMAIN_CPU_MODE_HOST_MODEL:
+        if (!kvm) {
+            g_set_error(error, GVIR_DESIGNER_DOMAIN_ERROR, 0,
+                        "Host CPU modes need a KVM domain");
+            return FALSE;
+        }
+        break;
+    case GVIR_DESIGNER_DOMAIN_CPU_MODE_CUSTOM:
+        name = gvir_designer_domain_get_host_cpu_model(design);
+        if (!name) {
+            g_set_error(error, GVIR_DESIGNER_DOMAIN_ERROR, 0,
+                        "Host capabilities do not name the CPU model");
+            return FALSE;
+        }
+        break;
+    default:
+        g_set_error(error, GVIR_DESIGNER_DOMAIN_ERROR, 0,
+                    "Unknown CPU mode '%d'", mode);
+        return FALSE;
+    }
+
+    cpu = gvir_designer_xml_ensure_child(gvir_designer_xml_get_node(GVIR_CONFIG_OBJECT(design->priv->config)),
+                                         "cpu");
+    model = gvir_designer_xml_get_child(cpu, "model");
+    if (model)
+        gvir_designer_xml_remove_node(model);
+
+    if (mode == GVIR_DESIGNER_DOMAIN_CPU_MODE_CUSTOM) {
+        gvir_designer_xml_set_attribute(cpu, "mode", "custom");
+        gvir_designer_xml_set_attribute(cpu, "match", "exact");
+        /* the first child, before any <numa> */
+        model = gvir_designer_xml_prepend_child(cpu, "model");
+        gvir_designer_xml_set_attribute(model, "fallback", "allow");
+        gvir_designer_xml_set_content(model, name);
+        g_free(name);
+    } else {
+        gvir_designer_xml_set_attribute(cpu, "mode",
+                                        mode == GVIR_DESIGNER_DOMAIN_CPU_MODE_HOST_MODEL ?
+                                        "host-model" : "host-passthrough");
+        gvir_designer_xml_set_attribute(cpu, "match", NULL);
+    }
+
+    return TRUE;
+}
+
+
+static gboolean
+gvir_designer_domain_host_has_cpu_feature(GVirDesignerDomain *design,
+                                          const char *name)
+{
+    xmlNodePtr node;
+    xmlNodePtr it;
+
+    node = gvir_designer_xml_get_child(gvir_designer_xml_get_node(GVIR_CONFIG_OBJECT(design->priv->caps)),
+                                       "host");
+    if (node)
+        node = gvir_designer_xml_get_child(node, "cpu");
+
+    for (it = node ? node->children : NULL; it != NULL; it = it->next) {
+        if (it->type == XML_ELEMENT_NODE &&
+            xmlStrEqual(it->name, (const xmlChar *)"feature") &&
+            gvir_designer_xml_has_attribute_value(it, "name", name))
+            return TRUE;
+    }
 
-    return ret;
+    return FALSE;
 }
 
+
 /**
- * gvir_designer_domain_add_interface_network:
+ * gvir_designer_domain_set_invariant_tsc:
  * @design: (transfer none): the domain designer instance
- * @network: (transfer none): network name
+ * @enable: whether the guest requires an invariant TSC
  * @error: return location for a #GError, or NULL
  *
- * Add new network interface card into @design. The interface is
- * of 'network' type with @network used as the source network.
+ * Makes the guest CPU advertise an invariant TSC, which ticks at a
+ * constant rate whatever the power state. Guests then use the TSC as
+ * their clock source, the cheapest one to read. The host CPU must have
+ * the 'invtsc' feature according to the capabilities. Such a guest can
+ * only be migrated to hosts with the same TSC frequency.
  *
- * Returns: (transfer full): the pointer to the new interface.
+ * Only KVM can pass the feature through, so call this after
+ * gvir_designer_domain_setup_machine(). The feature has to be added to
+ * a CPU model: unless gvir_designer_domain_setup_cpu() already picked
+ * one, the host-model mode is set.
+ *
+ * Returns: TRUE on success, FALSE with @error set otherwise.
  */
-GVirConfigDomainInterface *
-gvir_designer_domain_add_interface_network(GVirDesignerDomain *design,
-                                           const char *network,
-                                           GError **error)
+gboolean
+gvir_designer_domain_set_invariant_tsc(GVirDesignerDomain *design,
+                                       gboolean enable,
+                                       GError **error)
 {
-    g_return_val_if_fail(GVIR_DESIGNER_IS_DOMAIN(design), NULL);
-    g_return_val_if_fail(network != NULL, NULL);
-    g_return_val_if_fail(!error_is_set(error), NULL);
+    xmlNodePtr cpu;
+    xmlNodePtr it;
 
-    GVirConfigDomainInterface *ret = NULL;
+    g_return_val_if_fail(GVIR_DESIGNER_IS_DOMAIN(design), FALSE);
+    g_return_val_if_fail(!error_is_set(error), FALSE);
 
-    ret = gvir_designer_domain_add_interface_full(design,
-                                                  GVIR_DESIGNER_DOMAIN_NIC_TYPE_NETWORK,
-                                                  network,
-                                                  error);
+    if (enable) {
+        if (gvir_config_domain_get_virt_type(design->priv->config) !=
+            GVIR_CONFIG_DOMAIN_VIRT_KVM) {
+            g_set_error(error, GVIR_DESIGNER_DOMAIN_ERROR, 0,
+                        "Invariant TSC needs a KVM domain");
+            return FALSE;
+        }
+        if (!gvir_designer_domain_host_has_cpu_feature(design, "invtsc")) {
+            g_set_error(error, GVIR_DESIGNER_DOMAIN_ERROR, 0,
+                        "Host CPU has no invariant TSC");
+            return FALSE;
+        }
+    }
 
-    return ret;
+    cpu = gvir_designer_xml_ensure_child(gvir_designer_xml_get_node(GVIR_CONFIG_OBJECT(design->priv->config)),
+                                         "cpu");
+
+    /* features without a model make an invalid custom CPU */
+    if (enable &&
+        !gvir_designer_xml_has_attribute_value(cpu, "mode", "host-passthrough") &&
+        !gvir_designer_xml_has_attribute_value(cpu, "mode", "host-model") &&
+        gvir_designer_xml_get_child(cpu, "model") == NULL &&
+        !gvir_designer_domain_setup_cpu(design,
+                                        GVIR_DESIGNER_DOMAIN_CPU_MODE_HOST_MODEL,
+                                        error))
+        return FALSE;
+    for (it = cpu->children; it != NULL; it = it->next) {
+        if (it->type == XML_ELEMENT_NODE &&
+            xmlStrEqual(it->name, (const xmlChar *)"feature") &&
+            gvir_designer_xml_has_attribute_value(it, "name", "invtsc"))
+            break;
+    }
+
+    if (!enable) {
+        if (it)
+            gvir_designer_xml_remove_node(it);
+        return TRUE;
+    }
+
+    if (it == NULL) {
+        it = gvir_designer_xml_add_child(cpu, "feature");
+        gvir_designer_xml_set_attribute(it, "policy", "require");
+        gvir_designer_xml_set_attribute(it, "name", "invtsc");
+    } else {
+        gvir_designer_xml_set_attribute(it, "policy", "require");
+    }
+
+    return TRUE;
+}
+
+
+/* Size in KiB of the pages backing the guest memory */
+static guint
+gvir_designer_domain_get_page_size(GVirDesignerDomain *design)
+{
+    return design->priv->hugepage_size ? design->priv->hugepage_size : 4;
+}
+
+
+/* Guest memory, and that of each guest NUMA cell, must be a whole
+ * number of pages */
+static guint64
+gvir_designer_domain_round_memory(GVirDesignerDomain *design,
+                                  guint64 memory)
+{
+    guint page_size = gvir_designer_domain_get_page_size(design);
+
+    return (memory + page_size - 1) / page_size * page_size;
+}
+
+
+/* Splits the guest memory evenly into the guest NUMA cells, in whole
+ * pages, the memory itself being rounded up first */
+static void
+gvir_designer_domain_split_cell_memory(GVirDesignerDomain *design)
+{
+    GVirConfigDomain *config = design->priv->config;
+    xmlNodePtr numa;
+    xmlNodePtr cell;
+    guint64 page_size = gvir_designer_domain_get_page_size(design);
+    guint64 memory;
+    guint64 n_pages;
+    guint n_cells = 0;
+    guint i = 0;
+
+    numa = gvir_designer_xml_get_child(gvir_designer_xml_get_node(GVIR_CONFIG_OBJECT(config)),
+                                       "cpu");
+    if (numa)
+        numa = gvir_designer_xml_get_child(numa, "numa");
+    if (numa == NULL)
+        return;
+
+    for (cell = numa->children; cell != NULL; cell = cell->next) {
+        if (cell->type == XML_ELEMENT_NODE &&
+            xmlStrEqual(cell->name, (const xmlChar *)"cell"))
+            n_cells++;
+    }
+    if (n_cells == 0)
+        return;
+
+    memory = gvir_designer_domain_round_memory(design,
+                                               gvir_config_domain_get_memory(config));
+    gvir_config_domain_set_memory(config, memory);
+    n_pages = memory / page_size;
+
+    for (cell = numa->children; cell != NULL; cell = cell->next) {
+        guint64 cell_memory;
+        gchar *str;
+
+        if (cell->type != XML_ELEMENT_NODE ||
+            !xmlStrEqual(cell->name, (const xmlChar *)"cell"))
+            continue;
+
+        cell_memory = (n_pages / n_cells + (i < n_pages % n_cells ? 1 : 0)) * page_size;
+        str = g_strdup_printf("%" G_GUINT64_FORMAT, cell_memory);
+        gvir_designer_xml_set_attribute(cell, "memory", str);
+        gvir_designer_xml_set_attribute(cell, "unit", "KiB");
+        g_free(str);
+        i++;
+    }
 }
 
+
 /**
- * gvir_designer_domain_add_interface_user:
+ * gvir_designer_domain_setup_resources:
  * @design: (transfer none): the domain designer instance
+ * @req: (transfer none): requirements to set
  * @error: return location for a #GError, or NULL
  *
- * Add new network interface card into @design. The interface is
- * of 'user' type.
+ * Set minimal or recommended resources on @design.
  *
- * Returns: (transfer full): the pointer to the new interface.
+ * Returns: (transfer none): TRUE when successfully set, FALSE otherwise.
  */
-GVirConfigDomainInterface *
-gvir_designer_domain_add_interface_user(GVirDesignerDomain *design,
-                                        GError **error)
+gboolean
+gvir_designer_domain_setup_resources(GVirDesignerDomain *design,
+                                     GVirDesignerDomainResources req,
+                                     GError **error)
 {
-    g_return_val_if_fail(GVIR_DESIGNER_IS_DOMAIN(design), NULL);
-    g_return_val_if_fail(!error_is_set(error), NULL);
+    g_return_val_if_fail(GVIR_DESIGNER_IS_DOMAIN(design), FALSE);
+    gboolean ret = FALSE;
+    OsinfoResourcesList *res_list_min = NULL, *res_list_rec = NULL;
+    GVirConfigDomainOs *os = gvir_config_domain_get_os(design->priv->config);
+    const gchar *design_arch = os ? gvir_config_domain_os_get_arch(os) : "";
+    gint n_cpus = -1;
+    gint64 ram = -1;
 
-    GVirConfigDomainInterface *ret = NULL;
+    /* If user request recommended settings those may just override
+     * only a few settings when compared to minimal. So we must implement
+     * inheritance here. */
+    res_list_min = osinfo_os_get_minimum_resources(design->priv->os);
+    res_list_rec = osinfo_os_get_recommended_resources(design->priv->os);
+    if (req ==GVIR_DESIGNER_DOMAIN_RESOURCES_MINIMAL) {
+        gvir_designer_domain_get_resources(res_list_min, design_arch,
+                                           &n_cpus, &ram);
+    } else if (req == GVIR_DESIGNER_DOMAIN_RESOURCES_RECOMMENDED) {
+        gvir_designer_domain_get_resources(res_list_min, design_arch,
+                                           &n_cpus, &ram);
+        gvir_designer_domain_get_resources(res_list_rec, design_arch,
+                                           &n_cpus, &ram);
+    } else {
+        g_set_error(error, GVIR_DESIGNER_DOMAIN_ERROR, 0,
+                    "Unknown resources argument: '%d'", req);
+        goto cleanup;
+    }
 
-    ret = gvir_designer_domain_add_interface_full(design,
-                                                  GVIR_DESIGNER_DOMAIN_NIC_TYPE_USER,
-                                                  NULL,
-                                                  error);
+    if ((n_cpus <= 0) && (ram <= 0)) {
+        g_set_error(error, GVIR_DESIGNER_DOMAIN_ERROR, 0,
+                    "Unable to find resources in libosinfo database");
+        goto cleanup;
+    }
+
+    if (n_cpus > 0)
+        gvir_config_domain_set_vcpus(design->priv->config, n_cpus);
+    if (ram > 0)
+        gvir_config_domain_set_memory(design->priv->config,
+                                      gvir_designer_domain_round_memory(design, ram));
+
+    ret = TRUE;
+
+cleanup:
+    if (res_list_min != NULL)
+        g_object_unref(G_OBJECT(res_list_min));
+    if (res_list_rec != NULL)
+        g_object_unref(G_OBJECT(res_list_rec));
+    if (os != NULL)
+        g_object_unref(G_OBJECT(os));
 
     return ret;
 }
 
-static GVirConfigDomainVideoModel
-gvir_designer_domain_video_model_str_to_enum(const char *model_str,
-                                             GError **error)
+static gint
+gvir_designer_host_cpu_compare(gconstpointer a, gconstpointer b)
 {
-    GVirConfigDomainVideoModel model;
+    const GVirDesignerHostCpu *cpu_a = a;
+    const GVirDesignerHostCpu *cpu_b = b;
+
+    if (cpu_a->socket != cpu_b->socket)
+        return cpu_a->socket < cpu_b->socket ? -1 : 1;
+    if (cpu_a->core != cpu_b->core)
+        return cpu_a->core < cpu_b->core ? -1 : 1;
+    if (cpu_a->id != cpu_b->id)
+        return cpu_a->id < cpu_b->id ? -1 : 1;
+    return 0;
+}
 
-    if (g_str_equal(model_str, "vga")) {
-        model = GVIR_CONFIG_DOMAIN_VIDEO_MODEL_VGA;
-    } else if (g_str_equal(model_str, "cirrus")) {
-        model = GVIR_CONFIG_DOMAIN_VIDEO_MODEL_CIRRUS;
-    } else if (g_str_equal(model_str, "vmvga")) {
-        model = GVIR_CONFIG_DOMAIN_VIDEO_MODEL_VMVGA;
-    } else if (g_str_equal(model_str, "xen")) {
-        model = GVIR_CONFIG_DOMAIN_VIDEO_MODEL_XEN;
-    } else if (g_str_equal(model_str, "vbox")) {
-        model = GVIR_CONFIG_DOMAIN_VIDEO_MODEL_VBOX;
-    } else if (g_str_equal(model_str, "qxl")) {
-        model = GVIR_CONFIG_DOMAIN_VIDEO_MODEL_QXL;
-    } else {
-        g_debug("unsupported video model type '%s'", model_str);
+
+/* <cells> of the host NUMA topology, NULL when it is not reported */
+static xmlNodePtr
+gvir_designer_domain_get_host_cells(GVirDesignerDomain *design)
+{
+    xmlNodePtr node;
+
+    node = gvir_designer_xml_get_child(gvir_designer_xml_get_node(GVIR_CONFIG_OBJECT(design->priv->caps)),
+                                       "host");
+    if (node)
+        node = gvir_designer_xml_get_child(node, "topology");
+    if (node)
+        node = gvir_designer_xml_get_child(node, "cells");
+
+    return node;
+}
+
+
+/* Host CPUs sorted by socket then core, so that the threads of a core
+ * are next to each other. Older libvirt does not report sockets and
+ * cores, NUMA cells and single-thread cores are assumed then. */
+static GArray *
+gvir_designer_domain_get_host_cpus(GVirDesignerDomain *design,
+                                   GError **error)
+{
+    GArray *cpus = g_array_new(FALSE, FALSE, sizeof(GVirDesignerHostCpu));
+    xmlNodePtr cells = gvir_designer_domain_get_host_cells(design);
+    xmlNodePtr node;
+    xmlNodePtr cell;
+    xmlNodePtr it;
+
+    for (cell = cells ? cells->children : NULL; cell != NULL; cell = cell->next) {
+        GVirDesignerHostCpu cpu = { 0, 0, 0, 0 };
+
+        if (cell->type != XML_ELEMENT_NODE ||
+            !xmlStrEqual(cell->name, (const xmlChar *)"cell"))
+            continue;
+
+        gvir_designer_xml_get_attribute_uint(cell, "id", &cpu.cell);
+        node = gvir_designer_xml_get_child(cell, "cpus");
+
+        for (it = node ? node->children : NULL; it != NULL; it = it->next) {
+            if (it->type != XML_ELEMENT_NODE ||
+                !gvir_designer_xml_get_attribute_uint(it, "id", &cpu.id))
+                continue;
+
+            cpu.socket = cpu.cell;
+            cpu.core = cpu.id;
+            gvir_designer_xml_get_attribute_uint(it, "socket_id", &cpu.socket);
+            gvir_designer_xml_get_attribute_uint(it, "core_id", &cpu.core);
+            g_array_append_val(cpus, cpu);
+        }
+    }
+
+    if (cpus->len == 0) {
         g_set_error(error, GVIR_DESIGNER_DOMAIN_ERROR, 0,
-                    "unsupported video model type '%s'", model_str);
-        model = GVIR_CONFIG_DOMAIN_VIDEO_MODEL_VGA;
+                    "Host capabilities do not describe the CPU topology");
+        g_array_unref(cpus);
+        return NULL;
     }
 
-    return model;
+    g_array_sort(cpus, gvir_designer_host_cpu_compare);
+
+    return cpus;
 }
 
-/* FIXME: belongs in platform descriptions, maybe useful as a last resort */
-static GVirConfigDomainVideoModel
-gvir_designer_domain_video_model_from_virt_type(GVirDesignerDomain *design)
+
+static void
+gvir_designer_cpuset_append(GString *cpuset, guint cpu)
 {
-    GVirConfigDomainVirtType virt_type;
-    GVirConfigDomainVideoModel model;
+    if (cpuset->len > 0)
+        g_string_append_c(cpuset, ',');
+    g_string_append_printf(cpuset, "%u", cpu);
+}
 
-    virt_type = gvir_config_domain_get_virt_type(design->priv->config);
-    switch (virt_type) {
-    case GVIR_CONFIG_DOMAIN_VIRT_QEMU:
-    case GVIR_CONFIG_DOMAIN_VIRT_KQEMU:
-    case GVIR_CONFIG_DOMAIN_VIRT_KVM:
-        model = GVIR_CONFIG_DOMAIN_VIDEO_MODEL_QXL;
-        break;
-    case GVIR_CONFIG_DOMAIN_VIRT_XEN:
-        model = GVIR_CONFIG_DOMAIN_VIDEO_MODEL_XEN;
-        break;
-    case GVIR_CONFIG_DOMAIN_VIRT_VMWARE:
-        model = GVIR_CONFIG_DOMAIN_VIDEO_MODEL_VMVGA;
-        break;
-    case GVIR_CONFIG_DOMAIN_VIRT_VBOX:
-        model = GVIR_CONFIG_DOMAIN_VIDEO_MODEL_VBOX;
-        break;
-    case GVIR_CONFIG_DOMAIN_VIRT_LXC:
-    case GVIR_CONFIG_DOMAIN_VIRT_UML:
-    case GVIR_CONFIG_DOMAIN_VIRT_OPENVZ:
-    case GVIR_CONFIG_DOMAIN_VIRT_VSERVER:
-    case GVIR_CONFIG_DOMAIN_VIRT_LDOM:
-    case GVIR_CONFIG_DOMAIN_VIRT_TEST:
-    case GVIR_CONFIG_DOMAIN_VIRT_HYPERV:
-    case GVIR_CONFIG_DOMAIN_VIRT_ONE:
-    case GVIR_CONFIG_DOMAIN_VIRT_PHYP:
-        model = GVIR_CONFIG_DOMAIN_VIDEO_MODEL_VGA;
-        break;
-    default:
-        g_warn_if_reached();
-        model = GVIR_CONFIG_DOMAIN_VIDEO_MODEL_VGA;
-        break;
+
+/**
+ * gvir_designer_domain_setup_cpu_pinning:
+ * @design: (transfer none): the domain designer instance
+ * @error: return location for a #GError, or NULL
+ *
+ * Pins each vCPU of @design to its own host CPU, using the host
+ * topology from the capabilities. All vCPUs are kept on the first
+ * socket which has enough CPUs for them, on consecutive threads of
+ * consecutive cores, so that they share caches and never cross the
+ * socket interconnect. The emulator threads are pinned to the rest of
+ * that socket, or share the vCPUs' CPUs when nothing is left.
+ *
+ * The vCPU count must be set beforehand, by
+ * gvir_designer_domain_setup_resources() for instance. Any existing
+ * <cputune> element is replaced.
+ *
+ * Returns: TRUE on success, FALSE with @error set otherwise.
+ */
+gboolean
+gvir_designer_domain_setup_cpu_pinning(GVirDesignerDomain *design,
+                                       GError **error)
+{
+    GArray *cpus;
+    GString *emulator = NULL;
+    xmlNodePtr domain;
+    xmlNodePtr cputune;
+    xmlNodePtr pin;
+    guint n_vcpus;
+    guint start, end;
+    guint i;
+    gboolean ret = FALSE;
+
+    g_return_val_if_fail(GVIR_DESIGNER_IS_DOMAIN(design), FALSE);
+    g_return_val_if_fail(!error_is_set(error), FALSE);
+
+    n_vcpus = gvir_config_domain_get_vcpus(design->priv->config);
+    if (n_vcpus == 0) {
+        g_set_error(error, GVIR_DESIGNER_DOMAIN_ERROR, 0,
+                    "The number of vCPUs must be set before pinning them");
+        return FALSE;
+    }
+
+    cpus = gvir_designer_domain_get_host_cpus(design, error);
+    if (!cpus)
+        return FALSE;
+
+    /* [start, end) is a whole socket */
+    for (start = 0; start < cpus->len; start = end) {
+        guint socket = g_array_index(cpus, GVirDesignerHostCpu, start).socket;
+
+        for (end = start;
+             end < cpus->len &&
+             g_array_index(cpus, GVirDesignerHostCpu, end).socket == socket;
+             end++)
+            ;
+        if (end - start >= n_vcpus)
+            break;
+    }
+
+    if (start == cpus->len) {
+        g_set_error(error, GVIR_DESIGNER_DOMAIN_ERROR, 0,
+                    "No host socket has %u CPUs", n_vcpus);
+        goto cleanup;
+    }
+
+    domain = gvir_designer_xml_get_node(GVIR_CONFIG_OBJECT(design->priv->config));
+    cputune = gvir_designer_xml_get_child(domain, "cputune");
+    if (cputune)
+        gvir_designer_xml_remove_node(cputune);
+    cputune = gvir_designer_xml_add_child(domain, "cputune");
+
+    emulator = g_string_new(NULL);
+    for (i = 0; i < n_vcpus; i++) {
+        guint cpu = g_array_index(cpus, GVirDesignerHostCpu, start + i).id;
+
+        pin = gvir_designer_xml_add_child(cputune, "vcpupin");
+        gvir_designer_xml_set_attribute_uint(pin, "vcpu", i);
+        gvir_designer_xml_set_attribute_uint(pin, "cpuset", cpu);
+        if (start + n_vcpus == end)
+            gvir_designer_cpuset_append(emulator, cpu);
+    }
+    for (i = start + n_vcpus; i < end; i++)
+        gvir_designer_cpuset_append(emulator,
+                                    g_array_index(cpus, GVirDesignerHostCpu, i).id);
+
+    pin = gvir_designer_xml_add_child(cputune, "emulatorpin");
+    gvir_designer_xml_set_attribute(pin, "cpuset", emulator->str);
+
+    ret = TRUE;
+
+cleanup:
+    if (emulator)
+        g_string_free(emulator, TRUE);
+    g_array_unref(cpus);
+    return ret;
+}
+
+
+static gint
+gvir_designer_uint_compare(gconstpointer a, gconstpointer b)
+{
+    guint uint_a = *(const guint *)a;
+    guint uint_b = *(const guint *)b;
+
+    return uint_a < uint_b ? -1 : (uint_a > uint_b ? 1 : 0);
+}
+
+
+/* Sorted IDs of the host cells which have CPUs */
+static GArray *
+gvir_designer_host_cpus_get_cells(GArray *cpus)
+{
+    GArray *cells = g_array_new(FALSE, FALSE, sizeof(guint));
+    guint i, j;
+
+    for (i = 0; i < cpus->len; i++) {
+        guint cell = g_array_index(cpus, GVirDesignerHostCpu, i).cell;
+
+        for (j = 0; j < cells->len; j++) {
+            if (g_array_index(cells, guint, j) == cell)
+                break;
+        }
+        if (j == cells->len)
+            g_array_append_val(cells, cell);
+    }
+    g_array_sort(cells, gvir_designer_uint_compare);
+
+    return cells;
+}
+
+
+static void
+gvir_designer_host_cpus_append_cell(GArray *cpus, guint cell, GString *cpuset)
+{
+    GArray *ids = g_array_new(FALSE, FALSE, sizeof(guint));
+    guint i;
+
+    for (i = 0; i < cpus->len; i++) {
+        const GVirDesignerHostCpu *cpu = &g_array_index(cpus, GVirDesignerHostCpu, i);
+
+        if (cpu->cell == cell)
+            g_array_append_val(ids, cpu->id);
     }
+    g_array_sort(ids, gvir_designer_uint_compare);
 
-    return model;
+    for (i = 0; i < ids->len; i++)
+        gvir_designer_cpuset_append(cpuset, g_array_index(ids, guint, i));
+    g_array_unref(ids);
 }
 
-static const gchar *
-gvir_designer_domain_get_preferred_video_model(GVirDesignerDomain *design,
-                                               GError **error)
+
+/* KiB of @page_size pages reserved on each host cell, keyed by cell ID */
+static GHashTable *
+gvir_designer_domain_get_host_pages(GVirDesignerDomain *design,
+                                    guint page_size)
 {
-    const gchar *ret = NULL;
-    OsinfoDeviceLink *dev_link = NULL;
-    OsinfoDevice *dev;
+    GHashTable *pages = g_hash_table_new_full(NULL, NULL, NULL, g_free);
+    xmlNodePtr cells = gvir_designer_domain_get_host_cells(design);
+    xmlNodePtr cell;
+    xmlNodePtr it;
+
+    for (cell = cells ? cells->children : NULL; cell != NULL; cell = cell->next) {
+        guint id = 0;
+
+        if (cell->type != XML_ELEMENT_NODE ||
+            !xmlStrEqual(cell->name, (const xmlChar *)"cell"))
+            continue;
+
+        gvir_designer_xml_get_attribute_uint(cell, "id", &id);
+
+        for (it = cell->children; it != NULL; it = it->next) {
+            guint size = 0;
+            guint64 count = 0;
+            guint64 *kib;
+
+            if (it->type != XML_ELEMENT_NODE ||
+                !xmlStrEqual(it->name, (const xmlChar *)"pages") ||
+                !gvir_designer_xml_get_attribute_uint(it, "size", &size) ||
+                size != page_size ||
+                !gvir_designer_xml_get_content_uint64(it, &count) ||
+                count == 0)
+                continue;
+
+            kib = g_new(guint64, 1);
+            *kib = count * size;
+            g_hash_table_insert(pages, GUINT_TO_POINTER(id), kib);
+        }
+    }
 
-    dev_link = gvir_designer_domain_get_preferred_device(design, "video", error);
-    if (!dev_link)
-        goto cleanup;
+    return pages;
+}
 
-    dev = osinfo_devicelink_get_target(dev_link);
-    if (dev)
-        ret = osinfo_device_get_name(dev);
 
-cleanup:
-    if (dev_link)
-        g_object_unref(dev_link);
-    return ret;
+static guint64
+gvir_designer_host_pages_total(GHashTable *pages)
+{
+    GHashTableIter iter;
+    gpointer value;
+    guint64 total = 0;
+
+    g_hash_table_iter_init(&iter, pages);
+    while (g_hash_table_iter_next(&iter, NULL, &value))
+        total += *(guint64 *)value;
+
+    return total;
 }
 
-static GVirConfigDomainVideoModel
-gvir_designer_domain_get_fallback_video_model(GVirDesignerDomain *design)
+
+/* Hugepage sizes the host knows of, whether pages are reserved or not.
+ * Cells list the base page size first, it is not a hugepage size. */
+static GArray *
+gvir_designer_domain_get_hugepage_sizes(GVirDesignerDomain *design)
 {
-    OsinfoDeviceList *supported_devices = NULL;
-    OsinfoFilter *filter = NULL;
-    OsinfoDevice *device = NULL;
-    const char *model_str;
-    GVirConfigDomainVideoModel model;
-    GError *error = NULL;
+    GArray *sizes = g_array_new(FALSE, FALSE, sizeof(guint));
+    xmlNodePtr cells = gvir_designer_domain_get_host_cells(design);
+    xmlNodePtr cell;
+    xmlNodePtr it;
+    guint i;
 
-    model = GVIR_CONFIG_DOMAIN_VIDEO_MODEL_VGA;
+    for (cell = cells ? cells->children : NULL; cell != NULL; cell = cell->next) {
+        gboolean base = TRUE;
 
-    filter = osinfo_filter_new();
-    osinfo_filter_add_constraint(filter, OSINFO_DEVICE_PROP_CLASS, "video");
-    supported_devices = gvir_designer_domain_get_supported_devices(design, filter);
-    if (supported_devices == NULL || osinfo_list_get_length(OSINFO_LIST(supported_devices)) == 0)
-        goto fallback;
+        if (cell->type != XML_ELEMENT_NODE)
+            continue;
 
-    device = OSINFO_DEVICE(osinfo_list_get_nth(OSINFO_LIST(supported_devices), 0));
-    model_str = osinfo_device_get_name(device);
-    model = gvir_designer_domain_video_model_str_to_enum(model_str,
-                                                         &error);
-    if (error != NULL) {
-        g_clear_error(&error);
-        goto fallback;
+        for (it = cell->children; it != NULL; it = it->next) {
+            guint size = 0;
+
+            if (it->type != XML_ELEMENT_NODE ||
+                !xmlStrEqual(it->name, (const xmlChar *)"pages") ||
+                !gvir_designer_xml_get_attribute_uint(it, "size", &size))
+                continue;
+
+            if (base) {
+                base = FALSE;
+                continue;
+            }
+
+            for (i = 0; i < sizes->len; i++) {
+                if (g_array_index(sizes, guint, i) == size)
+                    break;
+            }
+            if (i == sizes->len)
+                g_array_append_val(sizes, size);
+        }
     }
-    goto end;
 
-fallback:
-    model = gvir_designer_domain_video_model_from_virt_type(design);
+    return sizes;
+}
 
-end:
-    if (filter != NULL)
-        g_object_unref(G_OBJECT(filter));
-    if (supported_devices != NULL)
-        g_object_unref(G_OBJECT(supported_devices));
 
-    return model;
+/* Largest hugepage size the host has reserved at least @memory KiB of */
+static guint
+gvir_designer_domain_pick_hugepage_size(GVirDesignerDomain *design,
+                                        guint64 memory)
+{
+    GArray *sizes = gvir_designer_domain_get_hugepage_sizes(design);
+    guint best = 0;
+    guint i;
+
+    for (i = 0; i < sizes->len; i++) {
+        guint size = g_array_index(sizes, guint, i);
+        GHashTable *pages;
+
+        if (size <= best)
+            continue;
+
+        pages = gvir_designer_domain_get_host_pages(design, size);
+        if (g_hash_table_size(pages) > 0 &&
+            gvir_designer_host_pages_total(pages) >= memory)
+            best = size;
+        g_hash_table_unref(pages);
+    }
+    g_array_unref(sizes);
+
+    return best;
+}
+
+
+/* When only some host nodes have pages of the hugepage size, binds the
+ * guest memory to them. Guest NUMA cells set up by
+ * gvir_designer_domain_setup_numa() are already placed on such nodes. */
+static void
+gvir_designer_domain_bind_hugepage_nodes(GVirDesignerDomain *design)
+{
+    xmlNodePtr domain = gvir_designer_xml_get_node(GVIR_CONFIG_OBJECT(design->priv->config));
+    xmlNodePtr cells = gvir_designer_domain_get_host_cells(design);
+    xmlNodePtr node;
+    GHashTable *pages;
+    GHashTableIter iter;
+    gpointer key;
+    GArray *nodes;
+    GString *nodeset;
+    guint n_cells = 0;
+    guint i;
+
+    if (gvir_designer_xml_get_child(domain, "numatune"))
+        return;
+
+    for (node = cells ? cells->children : NULL; node != NULL; node = node->next) {
+        if (node->type == XML_ELEMENT_NODE)
+            n_cells++;
+    }
+
+    pages = gvir_designer_domain_get_host_pages(design, design->priv->hugepage_size);
+    if (g_hash_table_size(pages) == 0 || g_hash_table_size(pages) >= n_cells) {
+        g_hash_table_unref(pages);
+        return;
+    }
+
+    nodeset = g_string_new(NULL);
+    nodes = g_array_new(FALSE, FALSE, sizeof(guint));
+    g_hash_table_iter_init(&iter, pages);
+    while (g_hash_table_iter_next(&iter, &key, NULL)) {
+        guint id = GPOINTER_TO_UINT(key);
+
+        g_array_append_val(nodes, id);
+    }
+    g_array_sort(nodes, gvir_designer_uint_compare);
+    for (i = 0; i < nodes->len; i++)
+        gvir_designer_cpuset_append(nodeset, g_array_index(nodes, guint, i));
+
+    node = gvir_designer_xml_add_child(gvir_designer_xml_add_child(domain, "numatune"),
+                                       "memory");
+    gvir_designer_xml_set_attribute(node, "mode", "strict");
+    gvir_designer_xml_set_attribute(node, "nodeset", nodeset->str);
+
+    g_string_free(nodeset, TRUE);
+    g_array_unref(nodes);
+    g_hash_table_unref(pages);
 }
 
+
+
+
 /**
- * gvir_designer_domain_add_video:
+ * gvir_designer_domain_setup_numa:
  * @design: (transfer none): the domain designer instance
  * @error: return location for a #GError, or NULL
  *
- * Add a new video device into @design.
+ * Splits the vCPUs and memory of @design evenly into guest NUMA cells,
+ * one per host NUMA node with CPUs (but no more cells than vCPUs), as
+ * found in the host topology from the capabilities. The memory of each
+ * guest cell is bound to its host node through <numatune> and its
+ * vCPUs may only run on that node's CPUs, so the guest sees the same
+ * locality as the host. This replaces any <cputune> set up by
+ * gvir_designer_domain_setup_cpu_pinning(), which keeps small guests
+ * on a single socket instead.
  *
- * Returns: (transfer full): the pointer to the new video device.
+ * Once gvir_designer_domain_setup_hugepages() has been called, only the
+ * host nodes with pages of that size reserved get guest cells, the
+ * others could not back their memory.
+ *
+ * The vCPU count and memory size must be set beforehand, by
+ * gvir_designer_domain_setup_resources() for instance. The memory is
+ * rounded up to a whole number of pages per cell. A host with a single
+ * node or a guest with a single vCPU is left flat.
+ *
+ * Returns: TRUE on success, FALSE with @error set otherwise.
  */
-GVirConfigDomainVideo *
-gvir_designer_domain_add_video(GVirDesignerDomain *design,
-                               GError **error)
+gboolean
+gvir_designer_domain_setup_numa(GVirDesignerDomain *design,
+                                GError **error)
 {
-    GVirConfigDomainVideo *video;
-    const gchar *model_str = NULL;
-    GVirConfigDomainVideoModel model;
+    GVirConfigDomain *config;
+    GArray *cpus;
+    GArray *host_cells;
+    GString *nodeset = NULL;
+    GString *emulator = NULL;
+    xmlNodePtr domain;
+    xmlNodePtr node;
+    xmlNodePtr numa;
+    xmlNodePtr numatune;
+    xmlNodePtr cputune;
+    guint64 memory;
+    guint n_vcpus;
+    guint n_cells;
+    guint vcpu = 0;
+    guint i;
 
-    g_return_val_if_fail(GVIR_DESIGNER_IS_DOMAIN(design), NULL);
-    g_return_val_if_fail(!error_is_set(error), NULL);
+    g_return_val_if_fail(GVIR_DESIGNER_IS_DOMAIN(design), FALSE);
+    g_return_val_if_fail(!error_is_set(error), FALSE);
 
-    model_str = gvir_designer_domain_get_preferred_video_model(design, NULL);
-    if (model_str != NULL) {
-        model = gvir_designer_domain_video_model_str_to_enum(model_str, error);
-        if (error_is_set(error)) {
-            g_clear_error(error);
-            model = gvir_designer_domain_get_fallback_video_model(design);
+    config = design->priv->config;
+    n_vcpus = gvir_config_domain_get_vcpus(config);
+    memory = gvir_config_domain_get_memory(config);
+    if (n_vcpus == 0 || memory == 0) {
+        g_set_error(error, GVIR_DESIGNER_DOMAIN_ERROR, 0,
+                    "The number of vCPUs and the memory size must be set "
+                    "before splitting them into NUMA cells");
+        return FALSE;
+    }
+
+    cpus = gvir_designer_domain_get_host_cpus(design, error);
+    if (!cpus)
+        return FALSE;
+
+    host_cells = gvir_designer_host_cpus_get_cells(cpus);
+    if (design->priv->hugepage_size > 0) {
+        GHashTable *pages;
+
+        pages = gvir_designer_domain_get_host_pages(design, design->priv->hugepage_size);
+        for (i = host_cells->len; i > 0; i--) {
+            if (!g_hash_table_lookup(pages,
+                                     GUINT_TO_POINTER(g_array_index(host_cells, guint, i - 1))))
+                g_array_remove_index(host_cells, i - 1);
         }
-    } else {
-        model = gvir_designer_domain_get_fallback_video_model(design);
+        g_hash_table_unref(pages);
+    }
+    n_cells = MIN(host_cells->len, n_vcpus);
+
+    domain = gvir_designer_xml_get_node(GVIR_CONFIG_OBJECT(config));
+
+    if (n_cells < 2) {
+        /* a previous layout may use nodes without hugepages */
+        node = gvir_designer_xml_get_child(domain, "cpu");
+        numa = node ? gvir_designer_xml_get_child(node, "numa") : NULL;
+        if (numa) {
+            gvir_designer_xml_remove_node(numa);
+            numatune = gvir_designer_xml_get_child(domain, "numatune");
+            if (numatune)
+                gvir_designer_xml_remove_node(numatune);
+            if (design->priv->hugepage_size > 0)
+                gvir_designer_domain_bind_hugepage_nodes(design);
+        }
+        goto cleanup;
     }
 
-    video = gvir_config_domain_video_new();
-    gvir_config_domain_video_set_model(video, model);
-    gvir_config_domain_add_device(design->priv->config,
-                                  GVIR_CONFIG_DOMAIN_DEVICE(video));
+    node = gvir_designer_xml_ensure_child(domain, "cpu");
+    numa = gvir_designer_xml_get_child(node, "numa");
+    if (numa)
+        gvir_designer_xml_remove_node(numa);
+    numa = gvir_designer_xml_add_child(node, "numa");
+
+    numatune = gvir_designer_xml_get_child(domain, "numatune");
+    if (numatune)
+        gvir_designer_xml_remove_node(numatune);
+    numatune = gvir_designer_xml_add_child(domain, "numatune");
+    node = gvir_designer_xml_add_child(numatune, "memory");
+
+    cputune = gvir_designer_xml_get_child(domain, "cputune");
+    if (cputune)
+        gvir_designer_xml_remove_node(cputune);
+    cputune = gvir_designer_xml_add_child(domain, "cputune");
+
+    nodeset = g_string_new(NULL);
+    emulator = g_string_new(NULL);
+
+    for (i = 0; i < n_cells; i++) {
+        guint host_cell = g_array_index(host_cells, guint, i);
+        guint cell_vcpus = n_vcpus / n_cells + (i < n_vcpus % n_cells ? 1 : 0);
+        GString *cell_cpus = g_string_new(NULL);
+        xmlNodePtr cell;
+        gchar *str;
+        guint j;
+
+        gvir_designer_host_cpus_append_cell(cpus, host_cell, cell_cpus);
+
+        cell = gvir_designer_xml_add_child(numa, "cell");
+        gvir_designer_xml_set_attribute_uint(cell, "id", i);
+        if (cell_vcpus == 1)
+            str = g_strdup_printf("%u", vcpu);
+        else
+            str = g_strdup_printf("%u-%u", vcpu, vcpu + cell_vcpus - 1);
+        gvir_designer_xml_set_attribute(cell, "cpus", str);
+        g_free(str);
+
+        cell = gvir_designer_xml_add_child(numatune, "memnode");
+        gvir_designer_xml_set_attribute_uint(cell, "cellid", i);
+        gvir_designer_xml_set_attribute(cell, "mode", "strict");
+        gvir_designer_xml_set_attribute_uint(cell, "nodeset", host_cell);
+
+        for (j = 0; j < cell_vcpus; j++, vcpu++) {
+            cell = gvir_designer_xml_add_child(cputune, "vcpupin");
+            gvir_designer_xml_set_attribute_uint(cell, "vcpu", vcpu);
+            gvir_designer_xml_set_attribute(cell, "cpuset", cell_cpus->str);
+        }
 
-    return video;
+        gvir_designer_cpuset_append(nodeset, host_cell);
+        if (emulator->len > 0)
+            g_string_append_c(emulator, ',');
+        g_string_append(emulator, cell_cpus->str);
+        g_string_free(cell_cpus, TRUE);
+    }
+
+    gvir_designer_xml_set_attribute(node, "mode", "strict");
+    gvir_designer_xml_set_attribute(node, "nodeset", nodeset->str);
+    gvir_designer_xml_set_attribute(gvir_designer_xml_add_child(cputune, "emulatorpin"),
+                                    "cpuset", emulator->str);
+
+    gvir_designer_domain_split_cell_memory(design);
+
+cleanup:
+    if (emulator)
+        g_string_free(emulator, TRUE);
+    if (nodeset)
+        g_string_free(nodeset, TRUE);
+    g_array_unref(host_cells);
+    g_array_unref(cpus);
+    return TRUE;
 }
 
 
-static void
-gvir_designer_domain_get_resources(OsinfoResourcesList *res_list,
-                                   const gchar *design_arch,
-                                   gint *design_n_cpus,
-                                   gint64 *design_ram)
+/**
+ * gvir_designer_domain_setup_hugepages:
+ * @design: (transfer none): the domain designer instance
+ * @page_size: page size in KiB, or 0
+ * @error: return location for a #GError, or NULL
+ *
+ * Backs the memory of @design with hugepages of @page_size KiB, which
+ * saves TLB misses and page table walks. With a @page_size of 0, the
+ * largest size of which the host has enough pages reserved for the
+ * guest memory is picked. The host reservations come from the NUMA
+ * topology in the capabilities; @page_size must be one of the host
+ * hugepage sizes, not its base page size. When only some host nodes
+ * have pages of that size, the guest memory is bound to them.
+ *
+ * From now on, gvir_designer_domain_setup_resources() rounds the
+ * memory up to a whole number of pages. The memory already set is
+ * rounded right away, and the guest NUMA cells set up by
+ * gvir_designer_domain_setup_numa() are laid out again on the nodes
+ * with pages, in whole pages.
+ *
+ * Returns: TRUE on success, FALSE with @error set otherwise.
+ */
+gboolean
+gvir_designer_domain_setup_hugepages(GVirDesignerDomain *design,
+                                     guint page_size,
+                                     GError **error)
 {
-    GList *elem_list, *elem_iterator;
+    GVirConfigDomain *config;
+    GHashTable *pages;
+    GArray *sizes;
+    xmlNodePtr domain;
+    xmlNodePtr backing;
+    xmlNodePtr node;
+    guint64 memory;
+    guint i;
 
-    if (!res_list)
-        return;
+    g_return_val_if_fail(GVIR_DESIGNER_IS_DOMAIN(design), FALSE);
+    g_return_val_if_fail(!error_is_set(error), FALSE);
 
-    elem_list = osinfo_list_get_elements(OSINFO_LIST(res_list));
-    for (elem_iterator = elem_list; elem_iterator; elem_iterator = elem_iterator->next) {
-        OsinfoResources *res = OSINFO_RESOURCES(elem_iterator->data);
-        const char *arch = osinfo_resources_get_architecture(res);
-        gint n_cpus = -1;
-        gint64 ram = -1;
+    config = design->priv->config;
+    memory = gvir_config_domain_get_memory(config);
 
-        if (g_str_equal(arch, "all") ||
-            g_str_equal(arch, design_arch)) {
-            n_cpus = osinfo_resources_get_n_cpus(res);
-            ram = osinfo_resources_get_ram(res);
-            if (n_cpus > 0) {
-                *design_n_cpus = n_cpus;
-            }
-            if (ram > 0) {
-                /* libosinfo returns RAM in B, libvirt-gconfig takes it in KB */
-                *design_ram = ram / 1024;
-            }
-            break;
+    if (page_size == 0) {
+        page_size = gvir_designer_domain_pick_hugepage_size(design, memory);
+        if (page_size == 0) {
+            g_set_error(error, GVIR_DESIGNER_DOMAIN_ERROR, 0,
+                        "Host has no hugepages reserved for %" G_GUINT64_FORMAT " KiB of memory",
+                        memory);
+            return FALSE;
         }
     }
-    g_list_free(elem_list);
+
+    sizes = gvir_designer_domain_get_hugepage_sizes(design);
+    for (i = 0; i < sizes->len; i++) {
+        if (g_array_index(sizes, guint, i) == page_size)
+            break;
+    }
+    if (i == sizes->len) {
+        g_set_error(error, GVIR_DESIGNER_DOMAIN_ERROR, 0,
+                    "%u KiB is not a hugepage size of the host", page_size);
+        g_array_unref(sizes);
+        return FALSE;
+    }
+    g_array_unref(sizes);
+
+    pages = gvir_designer_domain_get_host_pages(design, page_size);
+    if (g_hash_table_size(pages) == 0) {
+        g_set_error(error, GVIR_DESIGNER_DOMAIN_ERROR, 0,
+                    "Host has no %u KiB pages reserved", page_size);
+        g_hash_table_unref(pages);
+        return FALSE;
+    }
+    g_hash_table_unref(pages);
+
+    design->priv->hugepage_size = page_size;
+    if (memory > 0)
+        gvir_config_domain_set_memory(config,
+                                      gvir_designer_domain_round_memory(design, memory));
+
+    domain = gvir_designer_xml_get_node(GVIR_CONFIG_OBJECT(config));
+    node = gvir_designer_xml_get_child(domain, "cpu");
+    if (node && gvir_designer_xml_get_child(node, "numa")) {
+        /* its cells may be on nodes without pages of that size */
+        if (!gvir_designer_domain_setup_numa(design, error))
+            return FALSE;
+    } else {
+        gvir_designer_domain_split_cell_memory(design);
+    }
+
+    backing = gvir_designer_xml_ensure_child(domain, "memoryBacking");
+    node = gvir_designer_xml_get_child(backing, "hugepages");
+    if (node)
+        gvir_designer_xml_remove_node(node);
+    node = gvir_designer_xml_add_child(gvir_designer_xml_prepend_child(backing, "hugepages"),
+                                       "page");
+    gvir_designer_xml_set_attribute_uint(node, "size", page_size);
+    gvir_designer_xml_set_attribute(node, "unit", "KiB");
+
+    gvir_designer_domain_bind_hugepage_nodes(design);
+
+    return TRUE;
+}
+
+
+/* libvirt adds a virtio balloon to QEMU domains which have none,
+ * @model "none" is needed to really go without */
+static void
+gvir_designer_domain_set_memballoon(GVirDesignerDomain *design,
+                                    const char *model,
+                                    gboolean autodeflate)
+{
+    xmlNodePtr devices;
+    xmlNodePtr balloon;
+
+    devices = gvir_designer_xml_ensure_child(gvir_designer_xml_get_node(GVIR_CONFIG_OBJECT(design->priv->config)),
+                                             "devices");
+    balloon = gvir_designer_xml_get_child(devices, "memballoon");
+    if (balloon)
+        gvir_designer_xml_remove_node(balloon);
+
+    balloon = gvir_designer_xml_add_child(devices, "memballoon");
+    gvir_designer_xml_set_attribute(balloon, "model", model);
+    if (autodeflate)
+        gvir_designer_xml_set_attribute(balloon, "autodeflate", "on");
 }
 
 
 /**
- * gvir_designer_domain_setup_resources:
+ * gvir_designer_domain_setup_profile:
  * @design: (transfer none): the domain designer instance
- * @req: (transfer none): requirements to set
+ * @profile: the workload class of the domain
  * @error: return location for a #GError, or NULL
  *
- * Set minimal or recommended resources on @design.
+ * Tunes @design for a class of workloads in one go, call it after
+ * gvir_designer_domain_setup_machine() and before adding disks and
+ * network interfaces, which pick up the settings below.
  *
- * Returns: (transfer none): TRUE when successfully set, FALSE otherwise.
+ * GVIR_DESIGNER_DOMAIN_PROFILE_THROUGHPUT, for batch and streaming
+ * work, sets the recommended resources, picks the CPU mode
+ * automatically, tunes the disks for throughput with one IOThread per
+ * vCPU (at most 4), sizes the NIC queues after the vCPUs and removes
+ * the balloon.
+ *
+ * GVIR_DESIGNER_DOMAIN_PROFILE_LATENCY, for interactive and real-time
+ * work, sets the recommended resources, picks the CPU mode
+ * automatically, tunes the disks for latency with one IOThread, sizes
+ * the NIC queues after the vCPUs, removes the balloon and keeps the
+ * memory out of KSM, whose copy-on-write faults cause stalls.
+ *
+ * GVIR_DESIGNER_DOMAIN_PROFILE_DENSITY, for many small guests on one
+ * host, sets the minimal resources, uses the migratable host-model CPU
+ * on KVM, keeps safe disk settings without IOThreads, uses a single NIC
+ * queue and adds a balloon which deflates when the guest runs out of
+ * memory.
+ *
+ * All profiles apply the paravirtual clock policy of
+ * gvir_designer_domain_setup_machine(): on KVM, Linux and Windows 7
+ * or later guests lose the HPET, which is costly to emulate and unused
+ * by them.
+ *
+ * Returns: TRUE on success, FALSE with @error set otherwise.
  */
 gboolean
-gvir_designer_domain_setup_resources(GVirDesignerDomain *design,
-                                     GVirDesignerDomainResources req,
-                                     GError **error)
+gvir_designer_domain_setup_profile(GVirDesignerDomain *design,
+                                   GVirDesignerDomainProfile profile,
+                                   GError **error)
 {
+    GVirDesignerDomainResources resources;
+    GVirDesignerDomainCpuMode cpu_mode = GVIR_DESIGNER_DOMAIN_CPU_MODE_AUTO;
+    GVirDesignerDomainDiskProfile disk_profile;
+    guint n_vcpus;
+    guint iothreads;
+    guint nic_queues = 0;
+    xmlNodePtr backing;
+
     g_return_val_if_fail(GVIR_DESIGNER_IS_DOMAIN(design), FALSE);
-    gboolean ret = FALSE;
-    OsinfoResourcesList *res_list_min = NULL, *res_list_rec = NULL;
-    GVirConfigDomainOs *os = gvir_config_domain_get_os(design->priv->config);
-    const gchar *design_arch = os ? gvir_config_domain_os_get_arch(os) : "";
-    gint n_cpus = -1;
-    gint64 ram = -1;
+    g_return_val_if_fail(!error_is_set(error), FALSE);
 
-    /* If user request recommended settings those may just override
-     * only a few settings when compared to minimal. So we must implement
-     * inheritance here. */
-    res_list_min = osinfo_os_get_minimum_resources(design->priv->os);
-    res_list_rec = osinfo_os_get_recommended_resources(design->priv->os);
-    if (req ==GVIR_DESIGNER_DOMAIN_RESOURCES_MINIMAL) {
-        gvir_designer_domain_get_resources(res_list_min, design_arch,
-                                           &n_cpus, &ram);
-    } else if (req == GVIR_DESIGNER_DOMAIN_RESOURCES_RECOMMENDED) {
-        gvir_designer_domain_get_resources(res_list_min, design_arch,
-                                           &n_cpus, &ram);
-        gvir_designer_domain_get_resources(res_list_rec, design_arch,
-                                           &n_cpus, &ram);
-    } else {
+    switch (profile) {
+    case GVIR_DESIGNER_DOMAIN_PROFILE_THROUGHPUT:
+        resources = GVIR_DESIGNER_DOMAIN_RESOURCES_RECOMMENDED;
+        disk_profile = GVIR_DESIGNER_DOMAIN_DISK_PROFILE_THROUGHPUT;
+        break;
+    case GVIR_DESIGNER_DOMAIN_PROFILE_LATENCY:
+        resources = GVIR_DESIGNER_DOMAIN_RESOURCES_RECOMMENDED;
+        disk_profile = GVIR_DESIGNER_DOMAIN_DISK_PROFILE_LATENCY;
+        break;
+    case GVIR_DESIGNER_DOMAIN_PROFILE_DENSITY:
+        resources = GVIR_DESIGNER_DOMAIN_RESOURCES_MINIMAL;
+        disk_profile = GVIR_DESIGNER_DOMAIN_DISK_PROFILE_SAFE;
+        nic_queues = 1;
+        if (gvir_config_domain_get_virt_type(design->priv->config) ==
+            GVIR_CONFIG_DOMAIN_VIRT_KVM)
+            cpu_mode = GVIR_DESIGNER_DOMAIN_CPU_MODE_HOST_MODEL;
+        break;
+    default:
         g_set_error(error, GVIR_DESIGNER_DOMAIN_ERROR, 0,
-                    "Unknown resources argument: '%d'", req);
-        goto cleanup;
+                    "Unknown profile '%d'", profile);
+        return FALSE;
     }
 
-    if ((n_cpus <= 0) && (ram <= 0)) {
-        g_set_error(error, GVIR_DESIGNER_DOMAIN_ERROR, 0,
-                    "Unable to find resources in libosinfo database");
-        goto cleanup;
+    if (!gvir_designer_domain_setup_resources(design, resources, error))
+        return FALSE;
+    if (!gvir_designer_domain_setup_cpu(design, cpu_mode, error))
+        return FALSE;
+
+    n_vcpus = gvir_config_domain_get_vcpus(design->priv->config);
+    switch (profile) {
+    case GVIR_DESIGNER_DOMAIN_PROFILE_THROUGHPUT:
+        iothreads = CLAMP(n_vcpus, 1, 4);
+        break;
+    case GVIR_DESIGNER_DOMAIN_PROFILE_LATENCY:
+        iothreads = 1;
+        break;
+    default:
+        iothreads = 0;
+        break;
     }
 
-    if (n_cpus > 0)
-        gvir_config_domain_set_vcpus(design->priv->config, n_cpus);
-    if (ram > 0)
-        gvir_config_domain_set_memory(design->priv->config, ram);
+    gvir_designer_domain_set_disk_profile(design, disk_profile);
+    gvir_designer_domain_set_iothreads(design, iothreads);
+    gvir_designer_domain_set_nic_queues(design, nic_queues);
+    gvir_designer_domain_setup_paravirt_clock(design);
 
-cleanup:
-    if (res_list_min != NULL)
-        g_object_unref(G_OBJECT(res_list_min));
-    if (res_list_rec != NULL)
-        g_object_unref(G_OBJECT(res_list_rec));
-    g_object_unref(G_OBJECT(os));
+    if (profile == GVIR_DESIGNER_DOMAIN_PROFILE_DENSITY) {
+        gvir_designer_domain_set_memballoon(design, "virtio", TRUE);
+    } else {
+        gvir_designer_domain_set_memballoon(design, "none", FALSE);
+    }
 
-    return ret;
+    if (profile == GVIR_DESIGNER_DOMAIN_PROFILE_LATENCY) {
+        backing = gvir_designer_xml_ensure_child(gvir_designer_xml_get_node(GVIR_CONFIG_OBJECT(design->priv->config)),
+                                                 "memoryBacking");
+        gvir_designer_xml_ensure_child(backing, "nosharepages");
+    }
+
+    return TRUE;
 }
 
+
 /**
  * gvir_designer_domain_add_driver:
  * @design: the domain designer instance
@@ -2374,7 +5494,7 @@ gvir_designer_domain_remove_all_drivers(GVirDesignerDomain *design,
     g_return_val_if_fail(!error_is_set(error), FALSE);
 
     g_object_unref(design->priv->drivers);
-    design->priv->drivers = NULL;
+    design->priv->drivers = osinfo_device_driverlist_new();
 
     return TRUE;
 }
@@ -51,6 +51,45 @@ typedef enum {
     GVIR_DESIGNER_DOMAIN_GRAPHICS_VNC,
 } GVirDesignerDomainGraphics;
 
+typedef enum {
+    GVIR_DESIGNER_DOMAIN_DISPLAY_LOCALITY_LOCAL,
+    GVIR_DESIGNER_DOMAIN_DISPLAY_LOCALITY_LAN,
+    GVIR_DESIGNER_DOMAIN_DISPLAY_LOCALITY_WAN,
+} GVirDesignerDomainDisplayLocality;
+
+typedef enum {
+    GVIR_DESIGNER_DOMAIN_USB_MODE_AUTO,
+    GVIR_DESIGNER_DOMAIN_USB_MODE_COMPANION,
+    GVIR_DESIGNER_DOMAIN_USB_MODE_XHCI,
+} GVirDesignerDomainUsbMode;
+
+typedef enum {
+    GVIR_DESIGNER_DOMAIN_DISK_PROFILE_SAFE,
+    GVIR_DESIGNER_DOMAIN_DISK_PROFILE_THROUGHPUT,
+    GVIR_DESIGNER_DOMAIN_DISK_PROFILE_LATENCY,
+    GVIR_DESIGNER_DOMAIN_DISK_PROFILE_SCRATCH,
+    GVIR_DESIGNER_DOMAIN_DISK_PROFILE_NONE,
+} GVirDesignerDomainDiskProfile;
+
+typedef enum {
+    GVIR_DESIGNER_DOMAIN_THIN_PROVISIONING_AUTO,
+    GVIR_DESIGNER_DOMAIN_THIN_PROVISIONING_ENABLED,
+    GVIR_DESIGNER_DOMAIN_THIN_PROVISIONING_DISABLED,
+} GVirDesignerDomainThinProvisioning;
+
+typedef enum {
+    GVIR_DESIGNER_DOMAIN_CPU_MODE_AUTO,
+    GVIR_DESIGNER_DOMAIN_CPU_MODE_HOST_PASSTHROUGH,
+    GVIR_DESIGNER_DOMAIN_CPU_MODE_HOST_MODEL,
+    GVIR_DESIGNER_DOMAIN_CPU_MODE_CUSTOM,
+} GVirDesignerDomainCpuMode;
+
+typedef enum {
+    GVIR_DESIGNER_DOMAIN_PROFILE_THROUGHPUT,
+    GVIR_DESIGNER_DOMAIN_PROFILE_LATENCY,
+    GVIR_DESIGNER_DOMAIN_PROFILE_DENSITY,
+} GVirDesignerDomainProfile;
+
 typedef struct _GVirDesignerDomain GVirDesignerDomain;
 typedef struct _GVirDesignerDomainPrivate GVirDesignerDomainPrivate;
 typedef struct _GVirDesignerDomainClass GVirDesignerDomainClass;
@@ -78,6 +117,12 @@ GVirDesignerDomain *gvir_designer_domain_new(OsinfoDb *osinfo_db,
                                              OsinfoPlatform *platform,
                                              GVirConfigCapabilities *caps);
 
+GVirDesignerDomain *gvir_designer_domain_new_from_config(OsinfoDb *osinfo_db,
+                                                         OsinfoOs *os,
+                                                         OsinfoPlatform *platform,
+                                                         GVirConfigCapabilities *caps,
+                                                         GVirConfigDomain *config);
+
 OsinfoOs *gvir_designer_domain_get_os(GVirDesignerDomain *design);
 
 OsinfoPlatform *gvir_designer_domain_get_platform(GVirDesignerDomain *design);
@@ -97,6 +142,8 @@ gboolean gvir_designer_domain_supports_container(GVirDesignerDomain *design);
 gboolean gvir_designer_domain_supports_container_full(GVirDesignerDomain *design,
                                                       const char *arch);
 
+void gvir_designer_domain_set_headless(GVirDesignerDomain *design,
+                                       gboolean headless);
 gboolean gvir_designer_domain_setup_machine(GVirDesignerDomain *design,
                                             GError **error);
 
@@ -139,6 +186,26 @@ GVirConfigDomainDisk *gvir_designer_domain_add_floppy_device(GVirDesignerDomain
                                                              const char *devpath,
                                                              GError **error);
 
+gboolean gvir_designer_domain_reserve_disk_target(GVirDesignerDomain *design,
+                                                  const char *target,
+                                                  GError **error);
+void gvir_designer_domain_set_virtio_scsi_threshold(GVirDesignerDomain *design,
+                                                    guint threshold);
+void gvir_designer_domain_set_disk_profile(GVirDesignerDomain *design,
+                                           GVirDesignerDomainDiskProfile profile);
+void gvir_designer_domain_set_thin_provisioning(GVirDesignerDomain *design,
+                                                GVirDesignerDomainThinProvisioning mode);
+gboolean gvir_designer_domain_set_disk_thin_provisioning(GVirDesignerDomain *design,
+                                                         GVirConfigDomainDisk *disk,
+                                                         gboolean enable,
+                                                         GError **error);
+void gvir_designer_domain_set_iothreads(GVirDesignerDomain *design,
+                                        guint iothreads);
+gboolean gvir_designer_domain_set_disk_iothread(GVirDesignerDomain *design,
+                                                GVirConfigDomainDisk *disk,
+                                                guint iothread,
+                                                GError **error);
+
 GVirConfigDomainInterface *gvir_designer_domain_add_interface_bridge(GVirDesignerDomain *design,
                                                                      const char *bridge,
                                                                      GError **error);
@@ -149,10 +216,21 @@ GVirConfigDomainInterface *gvir_designer_domain_add_interface_network(GVirDesign
 
 GVirConfigDomainInterface *gvir_designer_domain_add_interface_user(GVirDesignerDomain *design,
                                                                    GError **error);
+GVirConfigDomainInterface *gvir_designer_domain_add_interface_direct(GVirDesignerDomain *design,
+                                                                     const char *dev,
+                                                                     GError **error);
+
+GVirConfigDomainInterface *gvir_designer_domain_add_interface_vhostuser(GVirDesignerDomain *design,
+                                                                        const char *socket_path,
+                                                                        GError **error);
+void gvir_designer_domain_set_nic_queues(GVirDesignerDomain *design,
+                                         guint queues);
 
 GVirConfigDomainGraphics *gvir_designer_domain_add_graphics(GVirDesignerDomain *design,
                                                             GVirDesignerDomainGraphics type,
                                                             GError **error);
+void gvir_designer_domain_set_display_locality(GVirDesignerDomain *design,
+                                               GVirDesignerDomainDisplayLocality locality);
 
 GVirConfigDomainSmartcard *gvir_designer_domain_add_smartcard(GVirDesignerDomain *design,
                                                               GError **error);
@@ -160,15 +238,44 @@ GVirConfigDomainSmartcard *gvir_designer_domain_add_smartcard(GVirDesignerDomain
 GVirConfigDomainSound *gvir_designer_domain_add_sound(GVirDesignerDomain *design,
                                                       GError **error);
 
+void gvir_designer_domain_set_machine_type(GVirDesignerDomain *design,
+                                           const char *machine);
+gboolean gvir_designer_domain_add_pcie_root_ports(GVirDesignerDomain *design,
+                                                  guint count,
+                                                  GError **error);
+
+void gvir_designer_domain_set_usb_mode(GVirDesignerDomain *design,
+                                       GVirDesignerDomainUsbMode mode);
 GVirConfigDomainRedirdev *gvir_designer_domain_add_usb_redir(GVirDesignerDomain *design,
                                                              GError **error);
 
 GVirConfigDomainVideo *gvir_designer_domain_add_video(GVirDesignerDomain *design,
                                                       GError **error);
+GVirConfigDomainVideo *gvir_designer_domain_add_video_full(GVirDesignerDomain *design,
+                                                           guint width,
+                                                           guint height,
+                                                           guint heads,
+                                                           GError **error);
 
 gboolean gvir_designer_domain_setup_resources(GVirDesignerDomain *design,
                                               GVirDesignerDomainResources req,
                                               GError **error);
+gboolean gvir_designer_domain_setup_profile(GVirDesignerDomain *design,
+                                            GVirDesignerDomainProfile profile,
+                                            GError **error);
+gboolean gvir_designer_domain_setup_cpu(GVirDesignerDomain *design,
+                                        GVirDesignerDomainCpuMode mode,
+                                        GError **error);
+gboolean gvir_designer_domain_set_invariant_tsc(GVirDesignerDomain *design,
+                                                gboolean enable,
+                                                GError **error);
+gboolean gvir_designer_domain_setup_cpu_pinning(GVirDesignerDomain *design,
+                                                GError **error);
+gboolean gvir_designer_domain_setup_numa(GVirDesignerDomain *design,
+                                         GError **error);
+gboolean gvir_designer_domain_setup_hugepages(GVirDesignerDomain *design,
+                                              guint page_size,
+                                              GError **error);
 
 gboolean gvir_designer_domain_remove_all_drivers(GVirDesignerDomain *design,
                                                  GError **error);
@@ -45,3 +45,217 @@ gvir_designer_genum_get_value(GType enum_type,
 
     g_return_val_if_reached(default_value);
 }
+
+
+G_GNUC_INTERNAL xmlNodePtr
+gvir_designer_xml_get_node(GVirConfigObject *object)
+{
+    xmlNodePtr node = NULL;
+
+    g_return_val_if_fail(GVIR_CONFIG_IS_OBJECT(object), NULL);
+
+    g_object_get(G_OBJECT(object), "node", &node, NULL);
+
+    return node;
+}
+
+
+/* First child element of @parent called @name, or NULL */
+G_GNUC_INTERNAL xmlNodePtr
+gvir_designer_xml_get_child(xmlNodePtr parent,
+                            const char *name)
+{
+    xmlNodePtr it;
+
+    g_return_val_if_fail(parent != NULL, NULL);
+
+    for (it = parent->children; it != NULL; it = it->next) {
+        if (it->type == XML_ELEMENT_NODE &&
+            xmlStrEqual(it->name, (const xmlChar *)name))
+            return it;
+    }
+
+    return NULL;
+}
+
+
+G_GNUC_INTERNAL xmlNodePtr
+gvir_designer_xml_ensure_child(xmlNodePtr parent,
+                               const char *name)
+{
+    xmlNodePtr child;
+
+    child = gvir_designer_xml_get_child(parent, name);
+    if (child == NULL)
+        child = gvir_designer_xml_add_child(parent, name);
+
+    return child;
+}
+
+
+/* Appends a new @name element to @parent */
+G_GNUC_INTERNAL xmlNodePtr
+gvir_designer_xml_add_child(xmlNodePtr parent,
+                            const char *name)
+{
+    g_return_val_if_fail(parent != NULL, NULL);
+
+    return xmlNewChild(parent, NULL, (const xmlChar *)name, NULL);
+}
+
+
+/* Inserts a new @name element before the other children of @parent */
+G_GNUC_INTERNAL xmlNodePtr
+gvir_designer_xml_prepend_child(xmlNodePtr parent,
+                                const char *name)
+{
+    xmlNodePtr child;
+
+    g_return_val_if_fail(parent != NULL, NULL);
+
+    if (parent->children == NULL)
+        return gvir_designer_xml_add_child(parent, name);
+
+    child = xmlNewDocNode(parent->doc, NULL, (const xmlChar *)name, NULL);
+
+    return xmlAddPrevSibling(parent->children, child);
+}
+
+
+G_GNUC_INTERNAL void
+gvir_designer_xml_remove_node(xmlNodePtr node)
+{
+    g_return_if_fail(node != NULL);
+
+    xmlUnlinkNode(node);
+    xmlFreeNode(node);
+}
+
+
+G_GNUC_INTERNAL gchar *
+gvir_designer_xml_get_attribute(xmlNodePtr node,
+                                const char *name)
+{
+    xmlChar *value;
+    gchar *ret;
+
+    g_return_val_if_fail(node != NULL, NULL);
+
+    value = xmlGetProp(node, (const xmlChar *)name);
+    if (value == NULL)
+        return NULL;
+
+    ret = g_strdup((const gchar *)value);
+    xmlFree(value);
+
+    return ret;
+}
+
+
+/* Returns FALSE, leaving @value alone, when the attribute is missing or
+ * not an unsigned integer */
+G_GNUC_INTERNAL gboolean
+gvir_designer_xml_get_attribute_uint(xmlNodePtr node,
+                                     const char *name,
+                                     guint *value)
+{
+    gchar *attr = gvir_designer_xml_get_attribute(node, name);
+    gchar *end = NULL;
+    guint64 parsed;
+    gboolean ret = FALSE;
+
+    if (attr == NULL)
+        return FALSE;
+
+    parsed = g_ascii_strtoull(attr, &end, 10);
+    if (end != attr && *end == '\0' && parsed <= G_MAXUINT) {
+        *value = parsed;
+        ret = TRUE;
+    }
+    g_free(attr);
+
+    return ret;
+}
+
+
+G_GNUC_INTERNAL gboolean
+gvir_designer_xml_has_attribute_value(xmlNodePtr node,
+                                      const char *name,
+                                      const char *value)
+{
+    gchar *attr = gvir_designer_xml_get_attribute(node, name);
+    gboolean ret = (g_strcmp0(attr, value) == 0);
+
+    g_free(attr);
+
+    return ret;
+}
+
+
+/* A NULL @value removes the attribute */
+G_GNUC_INTERNAL void
+gvir_designer_xml_set_attribute(xmlNodePtr node,
+                                const char *name,
+                                const char *value)
+{
+    g_return_if_fail(node != NULL);
+
+    if (value == NULL)
+        xmlUnsetProp(node, (const xmlChar *)name);
+    else
+        xmlSetProp(node, (const xmlChar *)name, (const xmlChar *)value);
+}
+
+
+G_GNUC_INTERNAL void
+gvir_designer_xml_set_attribute_uint(xmlNodePtr node,
+                                     const char *name,
+                                     guint value)
+{
+    gchar *str = g_strdup_printf("%u", value);
+
+    gvir_designer_xml_set_attribute(node, name, str);
+    g_free(str);
+}
+
+
+G_GNUC_INTERNAL void
+gvir_designer_xml_set_content(xmlNodePtr node,
+                              const char *content)
+{
+    xmlChar *encoded;
+
+    g_return_if_fail(node != NULL);
+
+    encoded = xmlEncodeSpecialChars(node->doc, (const xmlChar *)content);
+    xmlNodeSetContent(node, encoded);
+    xmlFree(encoded);
+}
+
+
+/* Returns FALSE, leaving @value alone, when the text of @node is not an
+ * unsigned integer */
+G_GNUC_INTERNAL gboolean
+gvir_designer_xml_get_content_uint64(xmlNodePtr node,
+                                     guint64 *value)
+{
+    xmlChar *content;
+    gchar *end = NULL;
+    guint64 parsed;
+    gboolean ret = FALSE;
+
+    g_return_val_if_fail(node != NULL, FALSE);
+
+    content = xmlNodeGetContent(node);
+    if (content == NULL)
+        return FALSE;
+
+    parsed = g_ascii_strtoull((const gchar *)content, &end, 10);
+    if (end != (gchar *)content && *end == '\0') {
+        *value = parsed;
+        ret = TRUE;
+    }
+    xmlFree(content);
+
+    return ret;
+}
@@ -24,8 +24,41 @@
 #ifndef __LIBVIRT_DESIGNER_INTERNAL_H__
 #define __LIBVIRT_DESIGNER_INTERNAL_H__
 
+#include <libxml/tree.h>
+
 int gvir_designer_genum_get_value(GType enum_type,
                                   const char *nick,
                                   gint default_value);
 
+/* Helpers for the parts of the domain XML libvirt-gconfig has no API for.
+ * Nodes belong to the document of the config object they come from. */
+xmlNodePtr gvir_designer_xml_get_node(GVirConfigObject *object);
+xmlNodePtr gvir_designer_xml_get_child(xmlNodePtr parent,
+                                       const char *name);
+xmlNodePtr gvir_designer_xml_ensure_child(xmlNodePtr parent,
+                                          const char *name);
+xmlNodePtr gvir_designer_xml_add_child(xmlNodePtr parent,
+                                       const char *name);
+xmlNodePtr gvir_designer_xml_prepend_child(xmlNodePtr parent,
+                                           const char *name);
+void gvir_designer_xml_remove_node(xmlNodePtr node);
+gchar *gvir_designer_xml_get_attribute(xmlNodePtr node,
+                                       const char *name);
+gboolean gvir_designer_xml_get_attribute_uint(xmlNodePtr node,
+                                              const char *name,
+                                              guint *value);
+gboolean gvir_designer_xml_has_attribute_value(xmlNodePtr node,
+                                               const char *name,
+                                               const char *value);
+void gvir_designer_xml_set_attribute(xmlNodePtr node,
+                                     const char *name,
+                                     const char *value);
+void gvir_designer_xml_set_attribute_uint(xmlNodePtr node,
+                                          const char *name,
+                                          guint value);
+void gvir_designer_xml_set_content(xmlNodePtr node,
+                                   const char *content);
+gboolean gvir_designer_xml_get_content_uint64(xmlNodePtr node,
+                                              guint64 *value);
+
 #endif /* __LIBVIRT_DESIGNER_INTERNAL_H__ */
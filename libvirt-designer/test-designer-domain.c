@@ -22,6 +22,8 @@
 
 #include <config.h>
 
+#include <string.h>
+
 #include <libvirt-designer/libvirt-designer.h>
 
 static const gchar *capsqemuxml =
@@ -125,6 +127,60 @@ static const gchar *capslxcxml =
     "  </guest>"
     "</capabilities>";
 
+/* Two sockets of two cores with two threads, numbered the way Linux
+ * does: first threads of all cores, then their siblings */
+static const gchar *capsnumaxml =
+    "<capabilities>"
+    "  <host>"
+    "    <uuid>b9d70ef8-6756-4b51-8901-f0e65af0dcd8</uuid>"
+    "    <cpu>"
+    "      <arch>x86_64</arch>"
+    "      <topology sockets='1' cores='2' threads='2'/>"
+    "      <feature name='invtsc'/>"
+    "    </cpu>"
+    "    <topology>"
+    "      <cells num='2'>"
+    "        <cell id='0'>"
+    "          <memory unit='KiB'>8388608</memory>"
+    "          <pages unit='KiB' size='4'>1572864</pages>"
+    "          <pages unit='KiB' size='2048'>1024</pages>"
+    "          <pages unit='KiB' size='1048576'>0</pages>"
+    "          <cpus num='4'>"
+    "            <cpu id='0' socket_id='0' core_id='0' siblings='0,4'/>"
+    "            <cpu id='1' socket_id='0' core_id='1' siblings='1,5'/>"
+    "            <cpu id='4' socket_id='0' core_id='0' siblings='0,4'/>"
+    "            <cpu id='5' socket_id='0' core_id='1' siblings='1,5'/>"
+    "          </cpus>"
+    "        </cell>"
+    "        <cell id='1'>"
+    "          <memory unit='KiB'>8388608</memory>"
+    "          <pages unit='KiB' size='4'>2097152</pages>"
+    "          <pages unit='KiB' size='2048'>0</pages>"
+    "          <pages unit='KiB' size='1048576'>0</pages>"
+    "          <cpus num='4'>"
+    "            <cpu id='2' socket_id='1' core_id='0' siblings='2,6'/>"
+    "            <cpu id='3' socket_id='1' core_id='1' siblings='3,7'/>"
+    "            <cpu id='6' socket_id='1' core_id='0' siblings='2,6'/>"
+    "            <cpu id='7' socket_id='1' core_id='1' siblings='3,7'/>"
+    "          </cpus>"
+    "        </cell>"
+    "      </cells>"
+    "    </topology>"
+    "  </host>"
+    "  <guest>"
+    "    <os_type>hvm</os_type>"
+    "    <arch name='x86_64'>"
+    "      <wordsize>64</wordsize>"
+    "      <emulator>/usr/bin/qemu-system-x86_64</emulator>"
+    "      <machine>pc</machine>"
+    "      <domain type='kvm'>"
+    "        <emulator>/usr/bin/qemu-kvm</emulator>"
+    "        <machine>pc</machine>"
+    "      </domain>"
+    "    </arch>"
+    "  </guest>"
+    "</capabilities>";
+
 static const gchar *domain_machine_simple_iso_result =
     "<domain>\n"
     "  <devices>\n"
@@ -140,12 +196,12 @@ static const gchar *domain_machine_simple_iso_result =
     "    </disk>\n"
     "    <disk type=\"file\">\n"
     "      <source file=\"/foo/bar3\"/>\n"
-    "      <driver name=\"qemu\" type=\"qcow2\"/>\n"
+    "      <driver name=\"qemu\" type=\"qcow2\" cache=\"none\" io=\"threads\" discard=\"unmap\"/>\n"
     "      <target bus=\"ide\" dev=\"hdc\"/>\n"
     "    </disk>\n"
     "    <disk type=\"block\">\n"
     "      <source dev=\"/foo/bar4\"/>\n"
-    "      <driver name=\"qemu\" type=\"raw\"/>\n"
+    "      <driver name=\"qemu\" type=\"raw\" cache=\"none\" io=\"native\"/>\n"
     "      <target bus=\"ide\" dev=\"hdd\"/>\n"
     "    </disk>\n"
     "    <disk type=\"file\">\n"
@@ -155,12 +211,43 @@ static const gchar *domain_machine_simple_iso_result =
     "    </disk>\n"
     "    <disk type=\"block\">\n"
     "      <source dev=\"/foo/bar6\"/>\n"
-    "      <driver name=\"qemu\" type=\"raw\"/>\n"
+    "      <driver name=\"qemu\" type=\"raw\" cache=\"none\" io=\"native\"/>\n"
     "      <target bus=\"ide\" dev=\"hdf\"/>\n"
     "    </disk>\n"
     "  </devices>\n"
     "</domain>";
 
+static const gchar *domain_existing_xml =
+    "<domain type='kvm'>"
+    "  <name>existing</name>"
+    "  <iothreads>2</iothreads>"
+    "  <devices>"
+    "    <disk type='file' device='disk'>"
+    "      <source file='/foo/existing1'/>"
+    "      <target dev='hda' bus='ide'/>"
+    "    </disk>"
+    "    <disk type='file' device='disk'>"
+    "      <source file='/foo/existing2'/>"
+    "      <target dev='hdc' bus='ide'/>"
+    "    </disk>"
+    "    <disk type='file' device='disk'>"
+    "      <driver name='qemu' iothread='1'/>"
+    "      <source file='/foo/existing3'/>"
+    "      <target dev='vda' bus='virtio'/>"
+    "    </disk>"
+    "    <controller type='scsi' index='0' model='lsilogic'/>"
+    "    <controller type='scsi' index='1' model='virtio-scsi'/>"
+    "    <controller type='usb' index='0' model='qemu-xhci' ports='4'/>"
+    "    <redirdev bus='usb' type='spicevmc'/>"
+    "    <redirdev bus='usb' type='spicevmc'/>"
+    "    <redirdev bus='usb' type='spicevmc'/>"
+    "    <redirdev bus='usb' type='spicevmc'/>"
+    "    <channel type='spicevmc'>"
+    "      <target type='virtio' name='com.redhat.spice.0'/>"
+    "    </channel>"
+    "  </devices>"
+    "</domain>";
+
 static void test_domain_machine_setup(GVirDesignerDomain **design, gconstpointer opaque)
 {
     OsinfoOs *os = osinfo_os_new("http://myoperatingsystem/amazing/4.2");
@@ -211,6 +298,153 @@ static void test_domain_machine_simple_disk_setup(GVirDesignerDomain **design, g
 }
 
 
+static void test_domain_machine_numa_setup(GVirDesignerDomain **design, gconstpointer opaque)
+{
+    OsinfoOs *os = osinfo_os_new("http://myoperatingsystem/amazing/4.2");
+    OsinfoDb *db = osinfo_db_new();
+    OsinfoPlatform *platform = osinfo_platform_new("http://myhypervisor.org/awesome/6.6.6");
+    GVirConfigCapabilities *caps = gvir_config_capabilities_new_from_xml(capsnumaxml, NULL);
+
+    *design = gvir_designer_domain_new(db, os, platform, caps);
+
+    g_object_unref(os);
+    g_object_unref(db);
+    g_object_unref(platform);
+    g_object_unref(caps);
+}
+
+
+/* capsnumaxml with 2 MiB pages on both cells */
+static void test_domain_machine_numa_pages_setup(GVirDesignerDomain **design, gconstpointer opaque)
+{
+    OsinfoOs *os = osinfo_os_new("http://myoperatingsystem/amazing/4.2");
+    OsinfoDb *db = osinfo_db_new();
+    OsinfoPlatform *platform = osinfo_platform_new("http://myhypervisor.org/awesome/6.6.6");
+    gchar **parts = g_strsplit(capsnumaxml, "<pages unit='KiB' size='2048'>0</pages>", 2);
+    gchar *xml = g_strjoinv("<pages unit='KiB' size='2048'>1024</pages>", parts);
+    GVirConfigCapabilities *caps = gvir_config_capabilities_new_from_xml(xml, NULL);
+
+    *design = gvir_designer_domain_new(db, os, platform, caps);
+
+    g_strfreev(parts);
+    g_free(xml);
+    g_object_unref(os);
+    g_object_unref(db);
+    g_object_unref(platform);
+    g_object_unref(caps);
+}
+
+
+static void test_domain_machine_resources_setup(GVirDesignerDomain **design, gconstpointer opaque)
+{
+    OsinfoOs *os = osinfo_os_new("http://myoperatingsystem/amazing/4.2");
+    OsinfoDb *db = osinfo_db_new();
+    OsinfoPlatform *platform = osinfo_platform_new("http://myhypervisor.org/awesome/6.6.6");
+    GVirConfigCapabilities *caps = gvir_config_capabilities_new_from_xml(capsqemuxml, NULL);
+    OsinfoResources *resources;
+
+    resources = osinfo_resources_new("http://myoperatingsystem/amazing/4.2/minimum", "all");
+    osinfo_resources_set_n_cpus(resources, 1);
+    osinfo_resources_set_ram(resources, 512 * 1024 * 1024);
+    osinfo_os_add_minimum_resources(os, resources);
+    g_object_unref(resources);
+
+    resources = osinfo_resources_new("http://myoperatingsystem/amazing/4.2/recommended", "all");
+    osinfo_resources_set_n_cpus(resources, 6);
+    osinfo_resources_set_ram(resources, 2048 * 1024 * 1024LL);
+    osinfo_os_add_recommended_resources(os, resources);
+    g_object_unref(resources);
+
+    *design = gvir_designer_domain_new(db, os, platform, caps);
+
+    g_object_unref(os);
+    g_object_unref(db);
+    g_object_unref(platform);
+    g_object_unref(caps);
+}
+
+
+/* @opaque is "<short-id> <version> [<family>]" */
+static void test_domain_machine_os_setup(GVirDesignerDomain **design, gconstpointer opaque)
+{
+    gchar **fields = g_strsplit(opaque, " ", 3);
+    OsinfoOs *os = osinfo_os_new("http://myoperatingsystem/amazing/4.2");
+    OsinfoDb *db = osinfo_db_new();
+    OsinfoPlatform *platform = osinfo_platform_new("http://myhypervisor.org/awesome/6.6.6");
+    GVirConfigCapabilities *caps = gvir_config_capabilities_new_from_xml(capsqemuxml, NULL);
+
+    osinfo_entity_set_param(OSINFO_ENTITY(os), OSINFO_PRODUCT_PROP_SHORT_ID, fields[0]);
+    osinfo_entity_set_param(OSINFO_ENTITY(os), OSINFO_PRODUCT_PROP_VERSION, fields[1]);
+    if (fields[2])
+        osinfo_entity_set_param(OSINFO_ENTITY(os), "family", fields[2]);
+
+    *design = gvir_designer_domain_new(db, os, platform, caps);
+
+    g_strfreev(fields);
+    g_object_unref(os);
+    g_object_unref(db);
+    g_object_unref(platform);
+    g_object_unref(caps);
+}
+
+
+static void test_domain_add_device(OsinfoDb *db,
+                                   OsinfoOs *os,
+                                   OsinfoPlatform *platform,
+                                   OsinfoDeployment *deployment,
+                                   const gchar *id,
+                                   const gchar *class,
+                                   const gchar *name,
+                                   const gchar *driver)
+{
+    OsinfoDevice *dev = osinfo_device_new(id);
+    OsinfoDeviceLink *dev_link;
+
+    osinfo_entity_set_param(OSINFO_ENTITY(dev), OSINFO_DEVICE_PROP_CLASS, class);
+    osinfo_entity_set_param(OSINFO_ENTITY(dev), OSINFO_DEVICE_PROP_NAME, name);
+    osinfo_db_add_device(db, dev);
+    osinfo_os_add_device(os, dev);
+    osinfo_platform_add_device(platform, dev);
+
+    if (deployment) {
+        dev_link = osinfo_deployment_add_device(deployment, dev);
+        if (driver)
+            osinfo_entity_set_param(OSINFO_ENTITY(dev_link),
+                                    OSINFO_DEVICELINK_PROP_DRIVER, driver);
+    }
+    g_object_unref(dev);
+}
+
+
+static void test_domain_machine_existing_setup(GVirDesignerDomain **design, gconstpointer opaque)
+{
+    OsinfoOs *os = osinfo_os_new("http://myoperatingsystem/amazing/4.2");
+    OsinfoDb *db = osinfo_db_new();
+    OsinfoPlatform *platform = osinfo_platform_new("http://myhypervisor.org/awesome/6.6.6");
+    GVirConfigCapabilities *caps = gvir_config_capabilities_new_from_xml(capsqemuxml, NULL);
+    GVirConfigDomain *config = gvir_config_domain_new_from_xml(domain_existing_xml, NULL);
+
+    osinfo_db_add_os(db, os);
+    osinfo_db_add_platform(db, platform);
+    test_domain_add_device(db, os, platform, NULL,
+                           "http://pciids.sourceforge.net/v2.2/pci.ids/1af4/1001",
+                           "block", "virtio-block", NULL);
+    test_domain_add_device(db, os, platform, NULL,
+                           "http://pciids.sourceforge.net/v2.2/pci.ids/1af4/1004",
+                           "block", "virtio-scsi", NULL);
+
+    g_assert(config);
+    *design = gvir_designer_domain_new_from_config(db, os, platform, caps, config);
+    g_assert(gvir_designer_domain_get_config(*design) == config);
+
+    g_object_unref(config);
+    g_object_unref(os);
+    g_object_unref(db);
+    g_object_unref(platform);
+    g_object_unref(caps);
+}
+
+
 static void test_domain_container_setup(GVirDesignerDomain **design, gconstpointer opaque)
 {
     OsinfoOs *os = osinfo_os_new("http://myoperatingsystem/amazing/4.2");
@@ -408,50 +642,1288 @@ static void test_domain_container_alt_arch_run(GVirDesignerDomain **design, gcon
     g_object_unref(osconfig);
 }
 
-static void test_domain_teardown(GVirDesignerDomain **design, gconstpointer opaque)
+static void test_domain_disk_targets_run(GVirDesignerDomain **design, gconstpointer opaque)
 {
-    if (*design)
-        g_object_unref(*design);
-    *design = NULL;
+    GError *error = NULL;
+    GVirConfigDomainDisk *disk;
+    gchar *path;
+    guint i;
+
+    g_assert(gvir_designer_domain_reserve_disk_target(*design, "hdb", &error));
+    g_assert(!gvir_designer_domain_reserve_disk_target(*design, "hdb", &error));
+    g_clear_error(&error);
+    g_assert(!gvir_designer_domain_reserve_disk_target(*design, "hda1", &error));
+    g_clear_error(&error);
+    g_assert(gvir_designer_domain_reserve_disk_target(*design, "vdzzz", &error));
+    g_assert(!gvir_designer_domain_reserve_disk_target(*design, "vdaaaa", &error));
+    g_clear_error(&error);
+    g_assert(!gvir_designer_domain_reserve_disk_target(*design, "vdzzzzzz", &error));
+    g_clear_error(&error);
+
+    /* hda, hdc, ..., hdz, hdaa, hdab, hdac */
+    for (i = 0; i < 28; i++) {
+        path = g_strdup_printf("/foo/bar%u", i);
+        disk = gvir_designer_domain_add_disk_file(*design, path, "raw", &error);
+        g_assert_no_error(error);
+        g_free(path);
+
+        if (i == 0)
+            g_assert_cmpstr(gvir_config_domain_disk_get_target_dev(disk), ==, "hda");
+        else if (i == 1)
+            g_assert_cmpstr(gvir_config_domain_disk_get_target_dev(disk), ==, "hdc");
+        else if (i == 25)
+            g_assert_cmpstr(gvir_config_domain_disk_get_target_dev(disk), ==, "hdaa");
+        else if (i == 27)
+            g_assert_cmpstr(gvir_config_domain_disk_get_target_dev(disk), ==, "hdac");
+        g_object_unref(disk);
+    }
+
+    g_assert(!gvir_designer_domain_reserve_disk_target(*design, "hdab", &error));
+    g_clear_error(&error);
+    g_assert(gvir_designer_domain_reserve_disk_target(*design, "hdad", &error));
+
+    disk = gvir_designer_domain_add_disk_file(*design, "/foo/last", "raw", &error);
+    g_assert_cmpstr(gvir_config_domain_disk_get_target_dev(disk), ==, "hdae");
+    g_object_unref(disk);
 }
 
-int main(int argc, char **argv)
+
+static guint test_domain_count_devices(GVirConfigDomain *config, GType type)
 {
-    GVirDesignerDomain *domain = NULL;
+    GList *devices, *it;
+    guint count = 0;
 
-    if (!gvir_designer_init_check(&argc, &argv, NULL))
-        return EXIT_FAILURE;
+    devices = gvir_config_domain_get_devices(config);
+    for (it = devices; it != NULL; it = it->next) {
+        if (g_type_is_a(G_OBJECT_TYPE(it->data), type))
+            count++;
+    }
+    g_list_free_full(devices, g_object_unref);
 
-    g_test_init(&argc, &argv, NULL);
-    g_test_add("/TestDesignerDomain/MachineHostArch",
-               GVirDesignerDomain *,
-               &domain,
-               test_domain_machine_setup,
-               test_domain_machine_host_arch_run,
-               test_domain_teardown);
-    g_test_add("/TestDesignerDomain/MachineAltArch",
-               GVirDesignerDomain *,
-               &domain,
-               test_domain_machine_setup,
-               test_domain_machine_alt_arch_run,
-               test_domain_teardown);
-    g_test_add("/TestDesignerDomain/ContainerHostArch",
-               GVirDesignerDomain *,
-               &domain,
-               test_domain_container_setup,
-               test_domain_container_host_arch_run,
-               test_domain_teardown);
-    g_test_add("/TestDesignerDomain/ContainerAltArch",
-               GVirDesignerDomain *,
-               &domain,
-               test_domain_container_setup,
-               test_domain_container_alt_arch_run,
-               test_domain_teardown);
-    g_test_add("/TestDesignerDomain/SimpleDisk",
-               GVirDesignerDomain *,
-               &domain,
-               test_domain_machine_simple_disk_setup,
-               test_domain_machine_simple_disk_run,
+    return count;
+}
+
+
+static void test_domain_machine_existing_run(GVirDesignerDomain **design, gconstpointer opaque)
+{
+    GError *error = NULL;
+    GVirConfigDomain *config;
+    GVirConfigDomainDisk *disk;
+    const gchar *scsi;
+    gchar *xml;
+
+    config = gvir_designer_domain_get_config(*design);
+    g_assert_cmpint(gvir_config_domain_get_virt_type(config),
+                    ==,
+                    GVIR_CONFIG_DOMAIN_VIRT_KVM);
+
+    /* vda is taken and IOThread 1 already has a disk */
+    disk = gvir_designer_domain_add_disk_file(*design, "/foo/bar1", "raw", &error);
+    g_assert_no_error(error);
+    g_assert_cmpstr(gvir_config_domain_disk_get_target_dev(disk), ==, "vdb");
+    xml = gvir_config_object_to_xml(GVIR_CONFIG_OBJECT(disk));
+    g_test_message("XML %s", xml);
+    g_assert(strstr(xml, "iothread=\"2\""));
+    g_free(xml);
+    g_assert(gvir_designer_domain_set_disk_iothread(*design, disk, 1, &error));
+    g_assert_no_error(error);
+    g_object_unref(disk);
+
+    /* the existing virtio-scsi controller is reused, not the lsilogic one */
+    gvir_designer_domain_set_virtio_scsi_threshold(*design, 2);
+    disk = gvir_designer_domain_add_disk_file(*design, "/foo/bar2", "raw", &error);
+    g_assert_no_error(error);
+    g_assert_cmpstr(gvir_config_domain_disk_get_target_dev(disk), ==, "sda");
+    xml = gvir_config_object_to_xml(GVIR_CONFIG_OBJECT(disk));
+    g_test_message("XML %s", xml);
+    g_assert(strstr(xml, "<address type=\"drive\" controller=\"1\" bus=\"0\" target=\"0\" unit=\"0\"/>"));
+    g_free(xml);
+    g_object_unref(disk);
+
+    /* neither USB controllers nor a second SPICE channel get added, the
+     * qemu-xhci controller gets a port for the fifth redirection */
+    g_object_unref(gvir_designer_domain_add_usb_redir(*design, &error));
+    g_assert_no_error(error);
+    g_object_unref(gvir_designer_domain_add_graphics(*design,
+                                                     GVIR_DESIGNER_DOMAIN_GRAPHICS_SPICE,
+                                                     &error));
+    g_assert_no_error(error);
+
+    g_assert_cmpuint(test_domain_count_devices(config, GVIR_CONFIG_TYPE_DOMAIN_DISK), ==, 5);
+    g_assert_cmpuint(test_domain_count_devices(config, GVIR_CONFIG_TYPE_DOMAIN_CONTROLLER_USB), ==, 1);
+    g_assert_cmpuint(test_domain_count_devices(config, GVIR_CONFIG_TYPE_DOMAIN_CHANNEL), ==, 1);
+    xml = gvir_config_object_to_xml(GVIR_CONFIG_OBJECT(config));
+    g_test_message("XML %s", xml);
+    g_assert(strstr(xml, "ports=\"5\""));
+    scsi = strstr(xml, "model=\"virtio-scsi\"");
+    g_assert(scsi && strstr(scsi + 1, "model=\"virtio-scsi\"") == NULL);
+    g_free(xml);
+}
+
+
+typedef struct {
+    const gchar *id;
+    const gchar *class;
+    const gchar *name;
+    const gchar *driver;
+    gboolean preferred;         /* linked to the deployment */
+} TestDomainDevice;
+
+static const TestDomainDevice test_domain_deployment_devices[] = {
+    { "http://pciids.sourceforge.net/v2.2/pci.ids/1af4/1001",
+      "block", "virtio-block", NULL, TRUE },
+    { "http://pciids.sourceforge.net/v2.2/pci.ids/1af4/1000",
+      "network", "virtio-net", "virtio", TRUE },
+    { "http://pciids.sourceforge.net/v2.2/pci.ids/8086/2668",
+      "audio", "ich6", NULL, TRUE },
+    { "http://pciids.sourceforge.net/v2.2/pci.ids/1b36/0100",
+      "video", "qxl", NULL, TRUE },
+    /* supported but not preferred */
+    { "http://pciids.sourceforge.net/v2.2/pci.ids/1af4/1004",
+      "block", "virtio-scsi", NULL, FALSE },
+    { "http://pciids.sourceforge.net/v2.2/pci.ids/1b36/000d",
+      "usb", "qemu-xhci", NULL, FALSE },
+    { "http://pciids.sourceforge.net/v2.2/pci.ids/1af4/1052",
+      "input", "virtio1.0-input", NULL, FALSE },
+    { "http://pciids.sourceforge.net/v2.2/pci.ids/1af4/1041",
+      "network", "virtio1.0-net", NULL, FALSE },
+    { NULL }
+};
+
+static const TestDomainDevice test_domain_legacy_nic_devices[] = {
+    { "http://pciids.sourceforge.net/v2.2/pci.ids/1af4/1000",
+      "network", "virtio-net", "virtio", TRUE },
+    { NULL }
+};
+
+static const TestDomainDevice test_domain_virtio_video_devices[] = {
+    { "http://pciids.sourceforge.net/v2.2/pci.ids/1af4/1050",
+      "video", "virtio1.0-gpu", NULL, TRUE },
+    { NULL }
+};
+
+
+/* @opaque is a TestDomainDevice table terminated by an entry with a
+ * NULL id */
+static void test_domain_machine_deployment_setup(GVirDesignerDomain **design, gconstpointer opaque)
+{
+    const TestDomainDevice *devices = opaque;
+    OsinfoOs *os = osinfo_os_new("http://myoperatingsystem/amazing/4.2");
+    OsinfoDb *db = osinfo_db_new();
+    OsinfoPlatform *platform = osinfo_platform_new("http://myhypervisor.org/awesome/6.6.6");
+    OsinfoDeployment *deployment = osinfo_deployment_new("http://mydeployment/amazing",
+                                                         os, platform);
+    GVirConfigCapabilities *caps = gvir_config_capabilities_new_from_xml(capsqemuxml, NULL);
+    guint i;
+
+    osinfo_db_add_os(db, os);
+    osinfo_db_add_platform(db, platform);
+    for (i = 0; devices[i].id != NULL; i++)
+        test_domain_add_device(db, os, platform,
+                               devices[i].preferred ? deployment : NULL,
+                               devices[i].id, devices[i].class,
+                               devices[i].name, devices[i].driver);
+    osinfo_db_add_deployment(db, deployment);
+
+    *design = gvir_designer_domain_new(db, os, platform, caps);
+
+    g_object_unref(deployment);
+    g_object_unref(os);
+    g_object_unref(db);
+    g_object_unref(platform);
+    g_object_unref(caps);
+}
+
+
+static void test_domain_virtio_scsi_run(GVirDesignerDomain **design, gconstpointer opaque)
+{
+    static const char *targets[] = { "vdb", "vdc", "sda", "sdb" };
+    GError *error = NULL;
+    GVirConfigDomainDisk *disk;
+    const gchar *controller;
+    gchar *xml;
+    guint i;
+
+    g_assert(gvir_designer_domain_setup_machine(*design, &error));
+    gvir_designer_domain_set_virtio_scsi_threshold(*design, 2);
+
+    /* CD-ROMs do not count towards the threshold */
+    disk = gvir_designer_domain_add_cdrom_file(*design, "/foo/install.iso", "raw", &error);
+    g_assert_no_error(error);
+    g_object_unref(disk);
+
+    for (i = 0; i < G_N_ELEMENTS(targets); i++) {
+        gchar *path = g_strdup_printf("/foo/bar%u", i);
+
+        disk = gvir_designer_domain_add_disk_file(*design, path, "raw", &error);
+        g_assert_no_error(error);
+        g_assert_cmpstr(gvir_config_domain_disk_get_target_dev(disk), ==, targets[i]);
+        g_assert_cmpint(gvir_config_domain_disk_get_target_bus(disk),
+                        ==,
+                        i < 2 ? GVIR_CONFIG_DOMAIN_DISK_BUS_VIRTIO :
+                                GVIR_CONFIG_DOMAIN_DISK_BUS_SCSI);
+        g_object_unref(disk);
+        g_free(path);
+    }
+
+    xml = gvir_config_object_to_xml(GVIR_CONFIG_OBJECT(gvir_designer_domain_get_config(*design)));
+    g_test_message("XML %s", xml);
+    /* a single controller serves all SCSI disks */
+    controller = strstr(xml, "<controller type=\"scsi\" index=\"0\" model=\"virtio-scsi\"/>");
+    g_assert(controller != NULL);
+    g_assert(strstr(controller + 1, "<controller type=\"scsi\"") == NULL);
+    g_free(xml);
+}
+
+
+static void test_domain_nic_queues_run(GVirDesignerDomain **design, gconstpointer opaque)
+{
+    GError *error = NULL;
+    GVirConfigDomainInterface *iface;
+    gchar *xml;
+
+    g_assert(gvir_designer_domain_setup_machine(*design, &error));
+    gvir_config_domain_set_vcpus(gvir_designer_domain_get_config(*design), 12);
+
+    iface = gvir_designer_domain_add_interface_network(*design, "default", &error);
+    g_assert_no_error(error);
+    xml = gvir_config_object_to_xml(GVIR_CONFIG_OBJECT(iface));
+    g_test_message("XML %s", xml);
+    g_assert(strstr(xml, "<driver name=\"vhost\" queues=\"8\"/>"));
+    g_free(xml);
+    g_object_unref(iface);
+
+    gvir_designer_domain_set_nic_queues(*design, 2);
+    iface = gvir_designer_domain_add_interface_bridge(*design, "br0", &error);
+    g_assert_no_error(error);
+    xml = gvir_config_object_to_xml(GVIR_CONFIG_OBJECT(iface));
+    g_assert(strstr(xml, "<driver name=\"vhost\" queues=\"2\"/>"));
+    g_free(xml);
+    g_object_unref(iface);
+
+    iface = gvir_designer_domain_add_interface_user(*design, &error);
+    g_assert_no_error(error);
+    xml = gvir_config_object_to_xml(GVIR_CONFIG_OBJECT(iface));
+    g_assert(strstr(xml, "<driver") == NULL);
+    g_free(xml);
+    g_object_unref(iface);
+}
+
+
+static void test_domain_nic_queues_legacy_run(GVirDesignerDomain **design, gconstpointer opaque)
+{
+    GError *error = NULL;
+    GVirConfigDomainInterface *iface;
+    gchar *xml;
+
+    g_assert(gvir_designer_domain_setup_machine(*design, &error));
+    gvir_config_domain_set_vcpus(gvir_designer_domain_get_config(*design), 12);
+
+    /* without virtio 1.0 support the driver may not handle multiqueue */
+    iface = gvir_designer_domain_add_interface_network(*design, "default", &error);
+    g_assert_no_error(error);
+    xml = gvir_config_object_to_xml(GVIR_CONFIG_OBJECT(iface));
+    g_test_message("XML %s", xml);
+    g_assert(strstr(xml, "<driver name=\"vhost\"/>"));
+    g_free(xml);
+    g_object_unref(iface);
+}
+
+
+static void test_domain_nic_backends_run(GVirDesignerDomain **design, gconstpointer opaque)
+{
+    GError *error = NULL;
+    GVirConfigDomainInterface *iface;
+    gchar *xml;
+
+    g_assert(gvir_designer_domain_setup_machine(*design, &error));
+
+    iface = gvir_designer_domain_add_interface_direct(*design, "eth0", &error);
+    g_assert_no_error(error);
+    xml = gvir_config_object_to_xml(GVIR_CONFIG_OBJECT(iface));
+    g_test_message("XML %s", xml);
+    g_assert(strstr(xml, "<interface type=\"direct\">"));
+    g_assert(strstr(xml, "<source dev=\"eth0\" mode=\"bridge\"/>"));
+    g_assert(strstr(xml, "<driver name=\"vhost\"/>"));
+    g_free(xml);
+    g_object_unref(iface);
+
+    iface = gvir_designer_domain_add_interface_vhostuser(*design, "/run/vhost.sock", &error);
+    g_assert_no_error(error);
+    xml = gvir_config_object_to_xml(GVIR_CONFIG_OBJECT(iface));
+    g_test_message("XML %s", xml);
+    g_assert(strstr(xml, "<interface type=\"vhostuser\">"));
+    g_assert(strstr(xml, "<source type=\"unix\" path=\"/run/vhost.sock\" mode=\"client\"/>"));
+    g_assert(strstr(xml, "<model type=\"virtio\"/>"));
+    g_free(xml);
+    g_object_unref(iface);
+
+    xml = gvir_config_object_to_xml(GVIR_CONFIG_OBJECT(gvir_designer_domain_get_config(*design)));
+    g_assert(strstr(xml, "<memoryBacking>"));
+    g_assert(strstr(xml, "<source type=\"memfd\"/>"));
+    g_assert(strstr(xml, "<access mode=\"shared\"/>"));
+    g_free(xml);
+}
+
+
+static void test_domain_disk_profile_run(GVirDesignerDomain **design, gconstpointer opaque)
+{
+    GError *error = NULL;
+    GVirConfigDomainDisk *disk;
+    gchar *xml;
+
+    gvir_designer_domain_set_disk_profile(*design, GVIR_DESIGNER_DOMAIN_DISK_PROFILE_THROUGHPUT);
+    disk = gvir_designer_domain_add_disk_file(*design, "/foo/bar1", "qcow2", &error);
+    g_assert_no_error(error);
+    xml = gvir_config_object_to_xml(GVIR_CONFIG_OBJECT(disk));
+    g_test_message("XML %s", xml);
+    g_assert(strstr(xml, "<driver name=\"qemu\" type=\"qcow2\" cache=\"none\" discard=\"unmap\" io=\"io_uring\"/>"));
+    g_free(xml);
+    g_object_unref(disk);
+
+    gvir_designer_domain_set_disk_profile(*design, GVIR_DESIGNER_DOMAIN_DISK_PROFILE_LATENCY);
+    disk = gvir_designer_domain_add_disk_device(*design, "/dev/sdb", &error);
+    g_assert_no_error(error);
+    xml = gvir_config_object_to_xml(GVIR_CONFIG_OBJECT(disk));
+    g_assert(strstr(xml, "<driver name=\"qemu\" type=\"raw\" cache=\"none\" io=\"native\" discard=\"ignore\"/>"));
+    g_free(xml);
+    g_object_unref(disk);
+
+    gvir_designer_domain_set_disk_profile(*design, GVIR_DESIGNER_DOMAIN_DISK_PROFILE_SCRATCH);
+    disk = gvir_designer_domain_add_disk_file(*design, "/foo/bar2", "raw", &error);
+    g_assert_no_error(error);
+    xml = gvir_config_object_to_xml(GVIR_CONFIG_OBJECT(disk));
+    g_assert(strstr(xml, "<driver name=\"qemu\" type=\"raw\" cache=\"unsafe\" io=\"threads\" discard=\"unmap\"/>"));
+    g_free(xml);
+    g_object_unref(disk);
+
+    gvir_designer_domain_set_disk_profile(*design, GVIR_DESIGNER_DOMAIN_DISK_PROFILE_NONE);
+    disk = gvir_designer_domain_add_disk_file(*design, "/foo/bar3", "raw", &error);
+    g_assert_no_error(error);
+    xml = gvir_config_object_to_xml(GVIR_CONFIG_OBJECT(disk));
+    g_assert(strstr(xml, "<driver name=\"qemu\" type=\"raw\"/>"));
+    g_free(xml);
+    g_object_unref(disk);
+}
+
+
+static void test_domain_iothreads_run(GVirDesignerDomain **design, gconstpointer opaque)
+{
+    static const char *iothreads[] = { "1", "2", "1" };
+    GError *error = NULL;
+    GVirConfigDomainDisk *disk;
+    gchar *xml;
+    gchar *driver;
+    guint i;
+
+    g_assert(gvir_designer_domain_setup_machine(*design, &error));
+    gvir_designer_domain_set_iothreads(*design, 2);
+
+    for (i = 0; i < G_N_ELEMENTS(iothreads); i++) {
+        disk = gvir_designer_domain_add_disk_file(*design, "/foo/bar", "raw", &error);
+        g_assert_no_error(error);
+        xml = gvir_config_object_to_xml(GVIR_CONFIG_OBJECT(disk));
+        g_test_message("XML %s", xml);
+        driver = g_strdup_printf("iothread=\"%s\"", iothreads[i]);
+        g_assert(strstr(xml, driver));
+        g_free(driver);
+        g_free(xml);
+
+        if (i == G_N_ELEMENTS(iothreads) - 1) {
+            g_assert(!gvir_designer_domain_set_disk_iothread(*design, disk, 3, &error));
+            g_clear_error(&error);
+            g_assert(gvir_designer_domain_set_disk_iothread(*design, disk, 2, &error));
+            xml = gvir_config_object_to_xml(GVIR_CONFIG_OBJECT(disk));
+            g_assert(strstr(xml, "iothread=\"2\""));
+            g_free(xml);
+        }
+        g_object_unref(disk);
+    }
+
+    xml = gvir_config_object_to_xml(GVIR_CONFIG_OBJECT(gvir_designer_domain_get_config(*design)));
+    g_assert(strstr(xml, "<iothreads>2</iothreads>"));
+    g_free(xml);
+
+    /* disks in IOThreads that go away are moved to the remaining ones */
+    gvir_designer_domain_set_iothreads(*design, 1);
+    xml = gvir_config_object_to_xml(GVIR_CONFIG_OBJECT(gvir_designer_domain_get_config(*design)));
+    g_test_message("XML %s", xml);
+    g_assert(strstr(xml, "<iothreads>1</iothreads>"));
+    g_assert(strstr(xml, "iothread=\"1\""));
+    g_assert(strstr(xml, "iothread=\"2\"") == NULL);
+    g_free(xml);
+
+    gvir_designer_domain_set_iothreads(*design, 0);
+    xml = gvir_config_object_to_xml(GVIR_CONFIG_OBJECT(gvir_designer_domain_get_config(*design)));
+    g_test_message("XML %s", xml);
+    g_assert(strstr(xml, "<iothreads>") == NULL);
+    g_assert(strstr(xml, "iothread=") == NULL);
+    g_free(xml);
+}
+
+
+static void test_domain_cpu_pinning_run(GVirDesignerDomain **design, gconstpointer opaque)
+{
+    GError *error = NULL;
+    GVirConfigDomain *config = gvir_designer_domain_get_config(*design);
+    gchar *xml;
+
+    /* no vCPU count yet */
+    g_assert(!gvir_designer_domain_setup_cpu_pinning(*design, &error));
+    g_clear_error(&error);
+
+    /* larger than any socket */
+    gvir_config_domain_set_vcpus(config, 5);
+    g_assert(!gvir_designer_domain_setup_cpu_pinning(*design, &error));
+    g_clear_error(&error);
+
+    gvir_config_domain_set_vcpus(config, 3);
+    g_assert(gvir_designer_domain_setup_cpu_pinning(*design, &error));
+    g_assert_no_error(error);
+
+    xml = gvir_config_object_to_xml(GVIR_CONFIG_OBJECT(config));
+    g_test_message("XML %s", xml);
+    /* both threads of core 0, then core 1 */
+    g_assert(strstr(xml, "<vcpupin vcpu=\"0\" cpuset=\"0\"/>"));
+    g_assert(strstr(xml, "<vcpupin vcpu=\"1\" cpuset=\"4\"/>"));
+    g_assert(strstr(xml, "<vcpupin vcpu=\"2\" cpuset=\"1\"/>"));
+    g_assert(strstr(xml, "<emulatorpin cpuset=\"5\"/>"));
+    g_free(xml);
+}
+
+
+static void test_domain_numa_run(GVirDesignerDomain **design, gconstpointer opaque)
+{
+    GError *error = NULL;
+    GVirConfigDomain *config = gvir_designer_domain_get_config(*design);
+    gchar *xml;
+
+    gvir_config_domain_set_vcpus(config, 3);
+    gvir_config_domain_set_memory(config, 4194305);
+    g_assert(gvir_designer_domain_setup_numa(*design, &error));
+    g_assert_no_error(error);
+
+    xml = gvir_config_object_to_xml(GVIR_CONFIG_OBJECT(config));
+    g_test_message("XML %s", xml);
+    /* rounded up to whole 4 KiB pages */
+    g_assert_cmpuint(gvir_config_domain_get_memory(config), ==, 4194308);
+    g_assert(strstr(xml, "<cell id=\"0\" cpus=\"0-1\" memory=\"2097156\" unit=\"KiB\"/>"));
+    g_assert(strstr(xml, "<cell id=\"1\" cpus=\"2\" memory=\"2097152\" unit=\"KiB\"/>"));
+    g_assert(strstr(xml, "<memory mode=\"strict\" nodeset=\"0,1\"/>"));
+    g_assert(strstr(xml, "<memnode cellid=\"1\" mode=\"strict\" nodeset=\"1\"/>"));
+    g_assert(strstr(xml, "<vcpupin vcpu=\"1\" cpuset=\"0,1,4,5\"/>"));
+    g_assert(strstr(xml, "<vcpupin vcpu=\"2\" cpuset=\"2,3,6,7\"/>"));
+    g_assert(strstr(xml, "<emulatorpin cpuset=\"0,1,4,5,2,3,6,7\"/>"));
+    g_free(xml);
+}
+
+
+static void test_domain_hugepages_run(GVirDesignerDomain **design, gconstpointer opaque)
+{
+    GError *error = NULL;
+    GVirConfigDomain *config = gvir_designer_domain_get_config(*design);
+    gchar *xml;
+
+    g_assert(!gvir_designer_domain_setup_hugepages(*design, 1048576, &error));
+    g_assert(error != NULL);
+    g_clear_error(&error);
+
+    /* the base page size is reserved everywhere but is no hugepage */
+    g_assert(!gvir_designer_domain_setup_hugepages(*design, 4, &error));
+    g_assert(error != NULL);
+    g_clear_error(&error);
+
+    /* only 2 GiB of 2 MiB pages */
+    gvir_config_domain_set_memory(config, 4194304);
+    g_assert(!gvir_designer_domain_setup_hugepages(*design, 0, &error));
+    g_clear_error(&error);
+
+    gvir_config_domain_set_memory(config, 1000000);
+    g_assert(gvir_designer_domain_setup_hugepages(*design, 0, &error));
+    g_assert_no_error(error);
+    g_assert_cmpuint(gvir_config_domain_get_memory(config), ==, 1001472);
+
+    xml = gvir_config_object_to_xml(GVIR_CONFIG_OBJECT(config));
+    g_test_message("XML %s", xml);
+    g_assert(strstr(xml, "<page size=\"2048\" unit=\"KiB\"/>"));
+    /* the other cell has no 2 MiB pages */
+    g_assert(strstr(xml, "<memory mode=\"strict\" nodeset=\"0\"/>"));
+    g_free(xml);
+}
+
+
+static void test_domain_numa_hugepages_run(GVirDesignerDomain **design, gconstpointer opaque)
+{
+    GError *error = NULL;
+    GVirConfigDomain *config = gvir_designer_domain_get_config(*design);
+    gchar *xml;
+
+    gvir_config_domain_set_vcpus(config, 2);
+    gvir_config_domain_set_memory(config, 1000000);
+    g_assert(gvir_designer_domain_setup_numa(*design, &error));
+    g_assert_no_error(error);
+
+    /* 489 pages of 2 MiB, cells must not split one */
+    g_assert(gvir_designer_domain_setup_hugepages(*design, 2048, &error));
+    g_assert_no_error(error);
+    g_assert_cmpuint(gvir_config_domain_get_memory(config), ==, 1001472);
+
+    xml = gvir_config_object_to_xml(GVIR_CONFIG_OBJECT(config));
+    g_test_message("XML %s", xml);
+    g_assert(strstr(xml, "<cell id=\"0\" cpus=\"0\" memory=\"501760\" unit=\"KiB\"/>"));
+    g_assert(strstr(xml, "<cell id=\"1\" cpus=\"1\" memory=\"499712\" unit=\"KiB\"/>"));
+    g_free(xml);
+}
+
+
+static void test_domain_numa_hugepages_partial_run(GVirDesignerDomain **design, gconstpointer opaque)
+{
+    GError *error = NULL;
+    GVirConfigDomain *config = gvir_designer_domain_get_config(*design);
+    gchar *xml;
+
+    gvir_config_domain_set_vcpus(config, 2);
+    gvir_config_domain_set_memory(config, 1000000);
+    g_assert(gvir_designer_domain_setup_numa(*design, &error));
+    g_assert_no_error(error);
+
+    /* only host node 0 has 2 MiB pages, the guest cells go away */
+    g_assert(gvir_designer_domain_setup_hugepages(*design, 2048, &error));
+    g_assert_no_error(error);
+    xml = gvir_config_object_to_xml(GVIR_CONFIG_OBJECT(config));
+    g_test_message("XML %s", xml);
+    g_assert(strstr(xml, "<numa>") == NULL);
+    g_assert(strstr(xml, "<memory mode=\"strict\" nodeset=\"0\"/>"));
+    g_free(xml);
+
+    /* and are not brought back on node 1 */
+    g_assert(gvir_designer_domain_setup_numa(*design, &error));
+    g_assert_no_error(error);
+    xml = gvir_config_object_to_xml(GVIR_CONFIG_OBJECT(config));
+    g_test_message("XML %s", xml);
+    g_assert(strstr(xml, "<numa>") == NULL);
+    g_assert(strstr(xml, "<memnode") == NULL);
+    g_assert(strstr(xml, "<memory mode=\"strict\" nodeset=\"0\"/>"));
+    g_free(xml);
+}
+
+
+static void test_domain_cpu_mode_run(GVirDesignerDomain **design, gconstpointer opaque)
+{
+    GError *error = NULL;
+    GVirConfigDomain *config = gvir_designer_domain_get_config(*design);
+    gchar *xml;
+
+    g_assert(gvir_designer_domain_setup_machine(*design, &error));
+    g_assert_cmpint(gvir_config_domain_get_virt_type(config), ==, GVIR_CONFIG_DOMAIN_VIRT_KVM);
+
+    g_assert(gvir_designer_domain_setup_cpu(*design, GVIR_DESIGNER_DOMAIN_CPU_MODE_AUTO, &error));
+    xml = gvir_config_object_to_xml(GVIR_CONFIG_OBJECT(config));
+    g_test_message("XML %s", xml);
+    g_assert(strstr(xml, "<cpu mode=\"host-passthrough\"/>"));
+    g_free(xml);
+
+    g_assert(gvir_designer_domain_setup_cpu(*design, GVIR_DESIGNER_DOMAIN_CPU_MODE_CUSTOM, &error));
+    xml = gvir_config_object_to_xml(GVIR_CONFIG_OBJECT(config));
+    g_test_message("XML %s", xml);
+    g_assert(strstr(xml, "<cpu mode=\"custom\" match=\"exact\">"));
+    g_assert(strstr(xml, "<model fallback=\"allow\">core2duo</model>"));
+    g_free(xml);
+
+    /* TCG cannot give the guest the host features */
+    gvir_config_domain_set_virt_type(config, GVIR_CONFIG_DOMAIN_VIRT_QEMU);
+    g_assert(!gvir_designer_domain_setup_cpu(*design, GVIR_DESIGNER_DOMAIN_CPU_MODE_HOST_MODEL, &error));
+    g_clear_error(&error);
+}
+
+
+static void test_domain_profile_run(GVirDesignerDomain **design, gconstpointer opaque)
+{
+    GError *error = NULL;
+    GVirConfigDomain *config = gvir_designer_domain_get_config(*design);
+    GVirConfigDomainDisk *disk;
+    gchar *xml;
+
+    g_assert(gvir_designer_domain_setup_machine(*design, &error));
+    g_assert(gvir_designer_domain_setup_profile(*design,
+                                                GVIR_DESIGNER_DOMAIN_PROFILE_THROUGHPUT,
+                                                &error));
+    g_assert_no_error(error);
+    g_assert_cmpuint(gvir_config_domain_get_vcpus(config), ==, 6);
+
+    disk = gvir_designer_domain_add_disk_file(*design, "/foo/bar", "qcow2", &error);
+    g_assert_no_error(error);
+    g_object_unref(disk);
+
+    xml = gvir_config_object_to_xml(GVIR_CONFIG_OBJECT(config));
+    g_test_message("XML %s", xml);
+    g_assert(strstr(xml, "<cpu mode=\"host-passthrough\"/>"));
+    g_assert(strstr(xml, "<iothreads>4</iothreads>"));
+    g_assert(strstr(xml, "io=\"io_uring\""));
+    /* nothing says the OS can do without it */
+    g_assert(strstr(xml, "hpet") == NULL);
+    g_assert(strstr(xml, "<memballoon model=\"none\"/>"));
+    g_free(xml);
+
+    g_assert(gvir_designer_domain_setup_profile(*design,
+                                                GVIR_DESIGNER_DOMAIN_PROFILE_DENSITY,
+                                                &error));
+    g_assert_no_error(error);
+    g_assert_cmpuint(gvir_config_domain_get_vcpus(config), ==, 1);
+
+    xml = gvir_config_object_to_xml(GVIR_CONFIG_OBJECT(config));
+    g_test_message("XML %s", xml);
+    g_assert(strstr(xml, "<cpu mode=\"host-model\"/>"));
+    g_assert(strstr(xml, "<iothreads>") == NULL);
+    g_assert(strstr(xml, "<memballoon model=\"virtio\" autodeflate=\"on\"/>"));
+    g_assert(strstr(xml, "<memballoon model=\"none\"/>") == NULL);
+    g_free(xml);
+}
+
+
+static void test_domain_hyperv_run(GVirDesignerDomain **design, gconstpointer opaque)
+{
+    GError *error = NULL;
+    GVirConfigDomain *config = gvir_designer_domain_get_config(*design);
+    gchar *xml;
+
+    g_assert(gvir_designer_domain_setup_machine(*design, &error));
+
+    xml = gvir_config_object_to_xml(GVIR_CONFIG_OBJECT(config));
+    g_test_message("XML %s", xml);
+    g_assert(strstr(xml, "<clock offset=\"localtime\">"));
+    g_assert(strstr(xml, "<spinlocks state=\"on\" retries=\"8191\"/>"));
+    if (g_str_has_prefix(opaque, "win7")) {
+        g_assert(strstr(xml, "<stimer state=\"on\"/>"));
+        g_assert(strstr(xml, "<timer name=\"hypervclock\" present=\"yes\"/>"));
+        g_assert(strstr(xml, "<timer name=\"hpet\" present=\"no\"/>"));
+    } else {
+        g_assert(strstr(xml, "<stimer") == NULL);
+        g_assert(strstr(xml, "hypervclock") == NULL);
+    }
+    g_free(xml);
+}
+
+
+static void test_domain_linux_clock_run(GVirDesignerDomain **design, gconstpointer opaque)
+{
+    GError *error = NULL;
+    gchar *xml;
+
+    g_assert(gvir_designer_domain_setup_machine(*design, &error));
+
+    xml = gvir_config_object_to_xml(GVIR_CONFIG_OBJECT(gvir_designer_domain_get_config(*design)));
+    g_test_message("XML %s", xml);
+    g_assert(strstr(xml, "<clock offset=\"utc\">"));
+    g_assert(strstr(xml, "<timer name=\"kvmclock\" present=\"yes\"/>"));
+    g_assert(strstr(xml, "<timer name=\"hpet\" present=\"no\"/>"));
+    g_free(xml);
+
+    /* capsqemuxml has no invariant TSC */
+    g_assert(!gvir_designer_domain_set_invariant_tsc(*design, TRUE, &error));
+    g_clear_error(&error);
+}
+
+
+static void test_domain_invtsc_run(GVirDesignerDomain **design, gconstpointer opaque)
+{
+    GError *error = NULL;
+    gchar *xml;
+
+    /* emulation cannot pass the feature through */
+    g_assert(!gvir_designer_domain_set_invariant_tsc(*design, TRUE, &error));
+    g_assert(error != NULL);
+    g_clear_error(&error);
+
+    g_assert(gvir_designer_domain_setup_machine(*design, &error));
+    g_assert(gvir_designer_domain_set_invariant_tsc(*design, TRUE, &error));
+    g_assert_no_error(error);
+
+    xml = gvir_config_object_to_xml(GVIR_CONFIG_OBJECT(gvir_designer_domain_get_config(*design)));
+    g_test_message("XML %s", xml);
+    g_assert(strstr(xml, "<cpu mode=\"host-model\">"));
+    g_assert(strstr(xml, "<feature policy=\"require\" name=\"invtsc\"/>"));
+    g_free(xml);
+
+    /* a CPU mode set beforehand is kept */
+    g_assert(gvir_designer_domain_setup_cpu(*design,
+                                            GVIR_DESIGNER_DOMAIN_CPU_MODE_HOST_PASSTHROUGH,
+                                            &error));
+    g_assert(gvir_designer_domain_set_invariant_tsc(*design, TRUE, &error));
+    g_assert_no_error(error);
+    xml = gvir_config_object_to_xml(GVIR_CONFIG_OBJECT(gvir_designer_domain_get_config(*design)));
+    g_test_message("XML %s", xml);
+    g_assert(strstr(xml, "<cpu mode=\"host-passthrough\">"));
+    g_assert(strstr(xml, "<feature policy=\"require\" name=\"invtsc\"/>"));
+    g_free(xml);
+
+    g_assert(gvir_designer_domain_set_invariant_tsc(*design, FALSE, &error));
+    xml = gvir_config_object_to_xml(GVIR_CONFIG_OBJECT(gvir_designer_domain_get_config(*design)));
+    g_assert(strstr(xml, "invtsc") == NULL);
+    g_free(xml);
+}
+
+
+static void test_domain_display_locality_run(GVirDesignerDomain **design, gconstpointer opaque)
+{
+    GError *error = NULL;
+    GVirConfigDomainGraphics *graphics;
+    gchar *xml;
+
+    g_assert(gvir_designer_domain_setup_machine(*design, &error));
+
+    graphics = gvir_designer_domain_add_graphics(*design, GVIR_DESIGNER_DOMAIN_GRAPHICS_SPICE, &error);
+    g_assert_no_error(error);
+    xml = gvir_config_object_to_xml(GVIR_CONFIG_OBJECT(graphics));
+    g_test_message("XML %s", xml);
+    g_assert(strstr(xml, "<image compression=\"off\"/>"));
+    g_assert(strstr(xml, "<streaming") == NULL);
+    g_free(xml);
+    g_object_unref(graphics);
+
+    gvir_designer_domain_set_display_locality(*design, GVIR_DESIGNER_DOMAIN_DISPLAY_LOCALITY_WAN);
+    graphics = gvir_designer_domain_add_graphics(*design, GVIR_DESIGNER_DOMAIN_GRAPHICS_SPICE, &error);
+    g_assert_no_error(error);
+    xml = gvir_config_object_to_xml(GVIR_CONFIG_OBJECT(graphics));
+    g_test_message("XML %s", xml);
+    g_assert(strstr(xml, "<image compression=\"auto_glz\"/>"));
+    g_assert(strstr(xml, "<jpeg compression=\"auto\"/>"));
+    g_assert(strstr(xml, "<zlib compression=\"auto\"/>"));
+    g_assert(strstr(xml, "<streaming mode=\"all\"/>"));
+    g_free(xml);
+    g_object_unref(graphics);
+}
+
+
+static void test_domain_video_run(GVirDesignerDomain **design, gconstpointer opaque)
+{
+    GError *error = NULL;
+    GVirConfigDomain *config = gvir_designer_domain_get_config(*design);
+    GVirConfigDomainVideo *video;
+    const gchar *short_id;
+    gchar *xml;
+
+    g_assert(gvir_designer_domain_setup_machine(*design, &error));
+
+    /* two 1920x1080 heads are 16 MiB of framebuffer */
+    video = gvir_designer_domain_add_video_full(*design, 1920, 1080, 2, &error);
+    g_assert_no_error(error);
+    g_assert_cmpint(gvir_config_domain_video_get_model(video), ==, GVIR_CONFIG_DOMAIN_VIDEO_MODEL_QXL);
+    xml = gvir_config_object_to_xml(GVIR_CONFIG_OBJECT(config));
+    g_test_message("XML %s", xml);
+    /* Windows gets one single head device per display */
+    short_id = osinfo_product_get_short_id(OSINFO_PRODUCT(gvir_designer_domain_get_os(*design)));
+    if (short_id && g_str_has_prefix(short_id, "win")) {
+        g_assert_cmpuint(test_domain_count_devices(config, GVIR_CONFIG_TYPE_DOMAIN_VIDEO), ==, 2);
+        g_assert(strstr(xml, "heads=") == NULL);
+        g_assert(strstr(xml, "vram=\"8192\""));
+    } else {
+        g_assert_cmpuint(test_domain_count_devices(config, GVIR_CONFIG_TYPE_DOMAIN_VIDEO), ==, 1);
+        g_assert(strstr(xml, "heads=\"2\""));
+        g_assert(strstr(xml, "ram=\"32768\""));
+        g_assert(strstr(xml, "vram=\"16384\""));
+    }
+    g_assert(strstr(xml, "vgamem=\"8192\""));
+    g_free(xml);
+    g_object_unref(video);
+
+    g_assert(gvir_designer_domain_add_video_full(*design, 1920, 0, 1, &error) == NULL);
+    g_assert(error != NULL);
+    g_clear_error(&error);
+}
+
+
+static void test_domain_video_virtio_run(GVirDesignerDomain **design, gconstpointer opaque)
+{
+    GError *error = NULL;
+    GVirConfigDomainVideo *video;
+    gchar *xml;
+
+    g_assert(gvir_designer_domain_setup_machine(*design, &error));
+
+    /* virtio-gpu sizes its memory itself, only the heads are set */
+    video = gvir_designer_domain_add_video_full(*design, 1920, 1080, 2, &error);
+    g_assert_no_error(error);
+    xml = gvir_config_object_to_xml(GVIR_CONFIG_OBJECT(video));
+    g_test_message("XML %s", xml);
+    g_assert(strstr(xml, "type=\"virtio\""));
+    g_assert(strstr(xml, "heads=\"2\""));
+    g_assert(strstr(xml, "vram=") == NULL);
+    g_free(xml);
+    g_object_unref(video);
+}
+
+
+static void test_domain_usb_xhci_run(GVirDesignerDomain **design, gconstpointer opaque)
+{
+    GError *error = NULL;
+    GVirConfigDomain *config = gvir_designer_domain_get_config(*design);
+    gchar *xml;
+    guint i;
+
+    g_assert(gvir_designer_domain_setup_machine(*design, &error));
+
+    /* the OS supports qemu-xhci, so a single controller is enough */
+    for (i = 0; i < 6; i++) {
+        g_object_unref(gvir_designer_domain_add_usb_redir(*design, &error));
+        g_assert_no_error(error);
+    }
+    g_assert_cmpuint(test_domain_count_devices(config, GVIR_CONFIG_TYPE_DOMAIN_CONTROLLER_USB), ==, 1);
+    xml = gvir_config_object_to_xml(GVIR_CONFIG_OBJECT(config));
+    g_test_message("XML %s", xml);
+    g_assert(strstr(xml, "model=\"qemu-xhci\""));
+    g_assert(strstr(xml, "ports=\"6\""));
+    g_free(xml);
+}
+
+
+static void test_domain_usb_companion_run(GVirDesignerDomain **design, gconstpointer opaque)
+{
+    GError *error = NULL;
+    GVirConfigDomain *config = gvir_designer_domain_get_config(*design);
+
+    g_assert(gvir_designer_domain_setup_machine(*design, &error));
+
+    /* nothing says the OS has an xHCI driver */
+    g_object_unref(gvir_designer_domain_add_usb_redir(*design, &error));
+    g_assert_no_error(error);
+    g_assert_cmpuint(test_domain_count_devices(config, GVIR_CONFIG_TYPE_DOMAIN_CONTROLLER_USB), ==, 4);
+}
+
+
+static void test_domain_input_run(GVirDesignerDomain **design, gconstpointer opaque)
+{
+    GError *error = NULL;
+    GVirConfigDomain *config = gvir_designer_domain_get_config(*design);
+    gchar *xml;
+
+    g_assert(gvir_designer_domain_setup_machine(*design, &error));
+
+    /* the OS has virtio-input drivers */
+    g_assert_cmpuint(test_domain_count_devices(config, GVIR_CONFIG_TYPE_DOMAIN_INPUT), ==, 2);
+    xml = gvir_config_object_to_xml(GVIR_CONFIG_OBJECT(config));
+    g_test_message("XML %s", xml);
+    g_assert(strstr(xml, "<input type=\"tablet\" bus=\"virtio\"/>"));
+    g_assert(strstr(xml, "<input type=\"keyboard\" bus=\"virtio\"/>"));
+    g_free(xml);
+}
+
+
+static void test_domain_headless_run(GVirDesignerDomain **design, gconstpointer opaque)
+{
+    GError *error = NULL;
+    GVirConfigDomain *config = gvir_designer_domain_get_config(*design);
+
+    gvir_designer_domain_set_headless(*design, TRUE);
+    g_assert(gvir_designer_domain_setup_machine(*design, &error));
+    g_assert_cmpuint(test_domain_count_devices(config, GVIR_CONFIG_TYPE_DOMAIN_INPUT), ==, 0);
+}
+
+
+static void test_domain_thin_provisioning_run(GVirDesignerDomain **design, gconstpointer opaque)
+{
+    GError *error = NULL;
+    GVirConfigDomainDisk *disk;
+    gchar *xml;
+
+    g_assert(gvir_designer_domain_setup_machine(*design, &error));
+
+    /* nothing says the OS sends discards */
+    disk = gvir_designer_domain_add_disk_file(*design, "/foo/bar1", "raw", &error);
+    g_assert_no_error(error);
+    xml = gvir_config_object_to_xml(GVIR_CONFIG_OBJECT(disk));
+    g_test_message("XML %s", xml);
+    g_assert(strstr(xml, "discard=") == NULL);
+    g_free(xml);
+    g_object_unref(disk);
+
+    gvir_designer_domain_set_thin_provisioning(*design, GVIR_DESIGNER_DOMAIN_THIN_PROVISIONING_ENABLED);
+    disk = gvir_designer_domain_add_disk_file(*design, "/foo/bar2", "raw", &error);
+    g_assert_no_error(error);
+    xml = gvir_config_object_to_xml(GVIR_CONFIG_OBJECT(disk));
+    g_test_message("XML %s", xml);
+    g_assert(strstr(xml, "discard=\"unmap\""));
+    g_assert(strstr(xml, "detect_zeroes=\"unmap\""));
+    g_free(xml);
+
+    g_assert(gvir_designer_domain_set_disk_thin_provisioning(*design, disk, FALSE, &error));
+    g_assert_no_error(error);
+    xml = gvir_config_object_to_xml(GVIR_CONFIG_OBJECT(disk));
+    g_test_message("XML %s", xml);
+    g_assert(strstr(xml, "discard=\"ignore\""));
+    g_assert(strstr(xml, "detect_zeroes=") == NULL);
+    g_free(xml);
+    g_object_unref(disk);
+}
+
+
+static void test_domain_pcie_root_ports_run(GVirDesignerDomain **design, gconstpointer opaque)
+{
+    GError *error = NULL;
+    GVirConfigDomain *config = gvir_designer_domain_get_config(*design);
+    gchar *xml;
+
+    g_assert(gvir_designer_domain_setup_machine(*design, &error));
+
+    /* the default i440fx machine has no PCI Express */
+    g_assert(!gvir_designer_domain_add_pcie_root_ports(*design, 2, &error));
+    g_assert(error != NULL);
+    g_clear_error(&error);
+
+    gvir_designer_domain_set_machine_type(*design, "q35");
+    g_object_unref(gvir_designer_domain_add_interface_network(*design, "default", &error));
+    g_assert_no_error(error);
+
+    /* the NIC and the implicit balloon take a port each */
+    g_assert(gvir_designer_domain_add_pcie_root_ports(*design, 2, &error));
+    g_assert_no_error(error);
+    g_assert(gvir_designer_domain_add_pcie_root_ports(*design, 2, &error));
+    g_assert_no_error(error);
+
+    xml = gvir_config_object_to_xml(GVIR_CONFIG_OBJECT(config));
+    g_test_message("XML %s", xml);
+    g_assert(strstr(xml, "machine=\"q35\""));
+    g_assert(strstr(xml, "<controller type=\"pci\" index=\"1\" model=\"pcie-root-port\"/>"));
+    g_assert(strstr(xml, "<controller type=\"pci\" index=\"4\" model=\"pcie-root-port\"/>"));
+    g_assert(strstr(xml, "index=\"5\"") == NULL);
+    g_free(xml);
+
+    /* a new NIC takes one of the spare ports, which gets replaced */
+    g_object_unref(gvir_designer_domain_add_interface_network(*design, "default", &error));
+    g_assert_no_error(error);
+    g_assert(gvir_designer_domain_add_pcie_root_ports(*design, 2, &error));
+    g_assert_no_error(error);
+
+    xml = gvir_config_object_to_xml(GVIR_CONFIG_OBJECT(config));
+    g_test_message("XML %s", xml);
+    g_assert(strstr(xml, "<controller type=\"pci\" index=\"5\" model=\"pcie-root-port\"/>"));
+    g_assert(strstr(xml, "index=\"6\"") == NULL);
+    g_free(xml);
+}
+
+
+static void test_domain_watch(GPtrArray *watched, gpointer object)
+{
+    gpointer *slot = g_new0(gpointer, 1);
+
+    *slot = object;
+    g_object_add_weak_pointer(G_OBJECT(object), slot);
+    g_ptr_array_add(watched, slot);
+}
+
+
+static void test_domain_watch_list(GPtrArray *watched, OsinfoList *list)
+{
+    gint i;
+
+    for (i = 0; i < osinfo_list_get_length(list); i++)
+        test_domain_watch(watched, osinfo_list_get_nth(list, i));
+    g_object_unref(list);
+}
+
+
+/* g_type_get_instance_count() appeared in GLib 2.44, the leak checks
+ * below compare 0 with 0 on older versions */
+#if GLIB_CHECK_VERSION(2, 44, 0)
+# define test_domain_instance_count(type) g_type_get_instance_count(type)
+#else
+# define test_domain_instance_count(type) 0
+#endif
+
+static void test_domain_finalize_run(GVirDesignerDomain **design, gconstpointer opaque)
+{
+    GError *error = NULL;
+    GPtrArray *watched = g_ptr_array_new_with_free_func(g_free);
+    OsinfoDb *db;
+    OsinfoOs *os;
+    OsinfoPlatform *platform;
+    OsinfoDeployment *deployment;
+    guint n_devlists, n_driverlists, n_filters;
+    guint i;
+
+    /* Instance counts are only maintained with GOBJECT_DEBUG=instance-count,
+     * which 'make check' sets, they are all 0 otherwise */
+    n_devlists = test_domain_instance_count(OSINFO_TYPE_DEVICELIST);
+    n_driverlists = test_domain_instance_count(OSINFO_TYPE_DEVICE_DRIVERLIST);
+    n_filters = test_domain_instance_count(OSINFO_TYPE_FILTER);
+
+    g_assert(gvir_designer_domain_setup_machine(*design, &error));
+    g_object_unref(gvir_designer_domain_add_disk_file(*design, "/foo/bar1",
+                                                      "qcow2", &error));
+    g_object_unref(gvir_designer_domain_add_disk_device(*design, "/foo/bar2",
+                                                        &error));
+    g_object_unref(gvir_designer_domain_add_interface_network(*design, "default",
+                                                              &error));
+    g_object_unref(gvir_designer_domain_add_sound(*design, &error));
+    g_object_unref(gvir_designer_domain_add_video(*design, &error));
+    g_assert(gvir_designer_domain_remove_all_drivers(*design, &error));
+    g_object_unref(gvir_designer_domain_add_disk_file(*design, "/foo/bar3",
+                                                      "raw", &error));
+    g_assert_no_error(error);
+
+    g_object_get(*design, "osinfo-db", &db, NULL);
+    os = g_object_ref(gvir_designer_domain_get_os(*design));
+    platform = g_object_ref(gvir_designer_domain_get_platform(*design));
+    deployment = osinfo_db_find_deployment(db, os, platform);
+    g_assert(deployment);
+
+    test_domain_watch(watched, *design);
+    test_domain_watch(watched, gvir_designer_domain_get_config(*design));
+    test_domain_watch(watched, gvir_designer_domain_get_capabilities(*design));
+    g_object_unref(*design);
+    *design = NULL;
+
+    for (i = 0; i < watched->len; i++)
+        g_assert(*(gpointer *)g_ptr_array_index(watched, i) == NULL);
+    g_assert_cmpuint(test_domain_instance_count(OSINFO_TYPE_DEVICELIST), ==, n_devlists);
+    g_assert_cmpuint(test_domain_instance_count(OSINFO_TYPE_DEVICE_DRIVERLIST), ==, n_driverlists);
+    g_assert_cmpuint(test_domain_instance_count(OSINFO_TYPE_FILTER), ==, n_filters);
+
+    /* The designer must not keep any of the database entities alive,
+     * nor drop references it does not own */
+    test_domain_watch(watched, db);
+    test_domain_watch(watched, os);
+    test_domain_watch(watched, platform);
+    test_domain_watch(watched, deployment);
+    test_domain_watch_list(watched,
+                           OSINFO_LIST(osinfo_deployment_get_device_links(deployment, NULL)));
+    test_domain_watch_list(watched,
+                           OSINFO_LIST(osinfo_db_get_device_list(db)));
+    g_object_unref(platform);
+    g_object_unref(os);
+    g_object_unref(db);
+
+    for (i = 0; i < watched->len; i++)
+        g_assert(*(gpointer *)g_ptr_array_index(watched, i) == NULL);
+
+    g_ptr_array_unref(watched);
+}
+
+
+static void test_domain_teardown(GVirDesignerDomain **design, gconstpointer opaque)
+{
+    if (*design)
+        g_object_unref(*design);
+    *design = NULL;
+}
+
+int main(int argc, char **argv)
+{
+    GVirDesignerDomain *domain = NULL;
+
+    if (!gvir_designer_init_check(&argc, &argv, NULL))
+        return EXIT_FAILURE;
+
+    g_test_init(&argc, &argv, NULL);
+    g_test_add("/TestDesignerDomain/MachineHostArch",
+               GVirDesignerDomain *,
+               &domain,
+               test_domain_machine_setup,
+               test_domain_machine_host_arch_run,
+               test_domain_teardown);
+    g_test_add("/TestDesignerDomain/MachineAltArch",
+               GVirDesignerDomain *,
+               &domain,
+               test_domain_machine_setup,
+               test_domain_machine_alt_arch_run,
+               test_domain_teardown);
+    g_test_add("/TestDesignerDomain/ContainerHostArch",
+               GVirDesignerDomain *,
+               &domain,
+               test_domain_container_setup,
+               test_domain_container_host_arch_run,
+               test_domain_teardown);
+    g_test_add("/TestDesignerDomain/ContainerAltArch",
+               GVirDesignerDomain *,
+               &domain,
+               test_domain_container_setup,
+               test_domain_container_alt_arch_run,
+               test_domain_teardown);
+    g_test_add("/TestDesignerDomain/SimpleDisk",
+               GVirDesignerDomain *,
+               &domain,
+               test_domain_machine_simple_disk_setup,
+               test_domain_machine_simple_disk_run,
+               test_domain_teardown);
+    g_test_add("/TestDesignerDomain/DiskProfile",
+               GVirDesignerDomain *,
+               &domain,
+               test_domain_machine_setup,
+               test_domain_disk_profile_run,
+               test_domain_teardown);
+    g_test_add("/TestDesignerDomain/DiskTargets",
+               GVirDesignerDomain *,
+               &domain,
+               test_domain_machine_setup,
+               test_domain_disk_targets_run,
+               test_domain_teardown);
+    g_test_add("/TestDesignerDomain/ExistingConfig",
+               GVirDesignerDomain *,
+               &domain,
+               test_domain_machine_existing_setup,
+               test_domain_machine_existing_run,
+               test_domain_teardown);
+    g_test_add("/TestDesignerDomain/VirtioScsi",
+               GVirDesignerDomain *,
+               test_domain_deployment_devices,
+               test_domain_machine_deployment_setup,
+               test_domain_virtio_scsi_run,
+               test_domain_teardown);
+    g_test_add("/TestDesignerDomain/NICQueues",
+               GVirDesignerDomain *,
+               test_domain_deployment_devices,
+               test_domain_machine_deployment_setup,
+               test_domain_nic_queues_run,
+               test_domain_teardown);
+    g_test_add("/TestDesignerDomain/NICQueues/legacy",
+               GVirDesignerDomain *,
+               test_domain_legacy_nic_devices,
+               test_domain_machine_deployment_setup,
+               test_domain_nic_queues_legacy_run,
+               test_domain_teardown);
+    g_test_add("/TestDesignerDomain/NICBackends",
+               GVirDesignerDomain *,
+               test_domain_deployment_devices,
+               test_domain_machine_deployment_setup,
+               test_domain_nic_backends_run,
+               test_domain_teardown);
+    g_test_add("/TestDesignerDomain/IOThreads",
+               GVirDesignerDomain *,
+               test_domain_deployment_devices,
+               test_domain_machine_deployment_setup,
+               test_domain_iothreads_run,
+               test_domain_teardown);
+    g_test_add("/TestDesignerDomain/CPUPinning",
+               GVirDesignerDomain *,
+               &domain,
+               test_domain_machine_numa_setup,
+               test_domain_cpu_pinning_run,
+               test_domain_teardown);
+    g_test_add("/TestDesignerDomain/NUMA",
+               GVirDesignerDomain *,
+               &domain,
+               test_domain_machine_numa_setup,
+               test_domain_numa_run,
+               test_domain_teardown);
+    g_test_add("/TestDesignerDomain/Hugepages",
+               GVirDesignerDomain *,
+               &domain,
+               test_domain_machine_numa_setup,
+               test_domain_hugepages_run,
+               test_domain_teardown);
+    g_test_add("/TestDesignerDomain/CPUMode",
+               GVirDesignerDomain *,
+               &domain,
+               test_domain_machine_setup,
+               test_domain_cpu_mode_run,
+               test_domain_teardown);
+    g_test_add("/TestDesignerDomain/Profile",
+               GVirDesignerDomain *,
+               &domain,
+               test_domain_machine_resources_setup,
+               test_domain_profile_run,
+               test_domain_teardown);
+    g_test_add("/TestDesignerDomain/HyperV/win7",
+               GVirDesignerDomain *,
+               "win7 6.1",
+               test_domain_machine_os_setup,
+               test_domain_hyperv_run,
+               test_domain_teardown);
+    g_test_add("/TestDesignerDomain/HyperV/win2k8",
+               GVirDesignerDomain *,
+               "win2k8 6.0",
+               test_domain_machine_os_setup,
+               test_domain_hyperv_run,
+               test_domain_teardown);
+    g_test_add("/TestDesignerDomain/LinuxClock",
+               GVirDesignerDomain *,
+               "fedora20 20 linux",
+               test_domain_machine_os_setup,
+               test_domain_linux_clock_run,
+               test_domain_teardown);
+    g_test_add("/TestDesignerDomain/InvariantTSC",
+               GVirDesignerDomain *,
+               &domain,
+               test_domain_machine_numa_setup,
+               test_domain_invtsc_run,
+               test_domain_teardown);
+    g_test_add("/TestDesignerDomain/DisplayLocality",
+               GVirDesignerDomain *,
+               test_domain_deployment_devices,
+               test_domain_machine_deployment_setup,
+               test_domain_display_locality_run,
+               test_domain_teardown);
+    g_test_add("/TestDesignerDomain/Video",
+               GVirDesignerDomain *,
+               test_domain_deployment_devices,
+               test_domain_machine_deployment_setup,
+               test_domain_video_run,
+               test_domain_teardown);
+    g_test_add("/TestDesignerDomain/Video/win7",
+               GVirDesignerDomain *,
+               "win7 6.1",
+               test_domain_machine_os_setup,
+               test_domain_video_run,
+               test_domain_teardown);
+    g_test_add("/TestDesignerDomain/Video/virtio",
+               GVirDesignerDomain *,
+               test_domain_virtio_video_devices,
+               test_domain_machine_deployment_setup,
+               test_domain_video_virtio_run,
+               test_domain_teardown);
+    g_test_add("/TestDesignerDomain/USB/xhci",
+               GVirDesignerDomain *,
+               test_domain_deployment_devices,
+               test_domain_machine_deployment_setup,
+               test_domain_usb_xhci_run,
+               test_domain_teardown);
+    g_test_add("/TestDesignerDomain/USB/companion",
+               GVirDesignerDomain *,
+               &domain,
+               test_domain_machine_setup,
+               test_domain_usb_companion_run,
+               test_domain_teardown);
+    g_test_add("/TestDesignerDomain/Input",
+               GVirDesignerDomain *,
+               test_domain_deployment_devices,
+               test_domain_machine_deployment_setup,
+               test_domain_input_run,
+               test_domain_teardown);
+    g_test_add("/TestDesignerDomain/Headless",
+               GVirDesignerDomain *,
+               &domain,
+               test_domain_machine_setup,
+               test_domain_headless_run,
+               test_domain_teardown);
+    g_test_add("/TestDesignerDomain/ThinProvisioning",
+               GVirDesignerDomain *,
+               test_domain_deployment_devices,
+               test_domain_machine_deployment_setup,
+               test_domain_thin_provisioning_run,
+               test_domain_teardown);
+    g_test_add("/TestDesignerDomain/PCIeRootPorts",
+               GVirDesignerDomain *,
+               &domain,
+               test_domain_machine_setup,
+               test_domain_pcie_root_ports_run,
+               test_domain_teardown);
+    g_test_add("/TestDesignerDomain/NUMA/Hugepages",
+               GVirDesignerDomain *,
+               &domain,
+               test_domain_machine_numa_pages_setup,
+               test_domain_numa_hugepages_run,
+               test_domain_teardown);
+    g_test_add("/TestDesignerDomain/NUMA/Hugepages/partial",
+               GVirDesignerDomain *,
+               &domain,
+               test_domain_machine_numa_setup,
+               test_domain_numa_hugepages_partial_run,
+               test_domain_teardown);
+    g_test_add("/TestDesignerDomain/Finalize",
+               GVirDesignerDomain *,
+               test_domain_deployment_devices,
+               test_domain_machine_deployment_setup,
+               test_domain_finalize_run,
                test_domain_teardown);
 
     return g_test_run();